@@ -0,0 +1,396 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "alarm.h"
+
+// ============ Default Rules ============
+// Used when no rules file is given: the database limits, plus the engine interlocks
+const char alarm_default_text[] =
+    "alarm coolant_high  coolant_temp > hi hyst=1 text=OVERHEATING!\n"
+    "alarm tyre_low      tyre_pressure < lo hyst=0.5 debounce=1000 text=LOW PRESSURE!\n"
+    "alarm tyre_high     tyre_pressure > hi hyst=0.5 debounce=1000 text=HIGH PRESSURE!\n"
+    "alarm battery_low   battery_voltage < lo hyst=0.2 debounce=2000 text=LOW BATTERY\n"
+    "alarm battery_high  battery_voltage > hi hyst=0.2 debounce=1000 text=OVERVOLTAGE\n"
+    "alarm over_rev      engine_rpm > hi hyst=200 text=OVER-REV!\n"
+    "alarm door_running  engine == running and door == 0 debounce=500 text=Door open while running\n"
+    "alarm belt_running  engine == running and seatbelt == 0 debounce=2000 text=Seat belt not fastened\n";
+
+// Operators
+#define OP_LT  0
+#define OP_LE  1
+#define OP_GT  2
+#define OP_GE  3
+#define OP_EQ  4
+#define OP_NE  5
+
+static const char *const op_names[] = {"<", "<=", ">", ">=", "==", "!="};
+
+static const char *const flag_names[ALARM_IN_SEATBELT + 1] = {
+    "left_ind", "right_ind", "headlight", "engine", "door", "seatbelt"
+};
+
+// ============ Parser ============
+#define MISSING  -2     // a signal or limit this database does not have
+
+struct alarm_names {
+    const struct signal_db *db;
+    uint32_t n_inputs;
+    const char *const *steps;
+    size_t n_steps;
+};
+
+// Any other name is taken for a signal, missing if the database has none by that name
+static int parse_input(const struct alarm_names *nm, const char *s) {
+    for (int i = 0; i <= ALARM_IN_SEATBELT; i++)
+        if (strcmp(s, flag_names[i]) == 0)
+            return i;
+    int32_t sig = signal_db_lookup(nm->db, s);
+    if (sig < 0 || nm->db->slot[sig] < 0 || ALARM_IN_SENSOR + (uint32_t)nm->db->slot[sig] >= nm->n_inputs)
+        return MISSING;
+    return ALARM_IN_SENSOR + nm->db->slot[sig];
+}
+
+// Threshold in the input's raw units; signals take physical values or their lo / hi limit
+static int parse_value(const struct alarm_names *nm, int input, const char *s, int64_t *out) {
+    char *end;
+
+    if (input < ALARM_IN_SENSOR) {
+        if (input == ALARM_IN_ENGINE)
+            for (size_t i = 0; i < nm->n_steps; i++)
+                if (strcmp(s, nm->steps[i]) == 0) {
+                    *out = i;
+                    return 0;
+                }
+        long v = strtol(s, &end, 10);
+        if (*s == '\0' || *end != '\0')
+            return -1;
+        *out = v;
+        return 0;
+    }
+
+    int32_t sig = nm->db->slot_signal[input - ALARM_IN_SENSOR];
+    if (strcmp(s, "lo") == 0 || strcmp(s, "hi") == 0) {
+        *out = (s[0] == 'l') ? nm->db->warn_lo_raw[sig] : nm->db->warn_hi_raw[sig];
+        return (*out == INT64_MIN || *out == INT64_MAX) ? MISSING : 0;
+    }
+    double phys = strtod(s, &end);
+    if (*s == '\0' || *end != '\0' || !isfinite(phys))
+        return -1;
+    *out = signal_raw_from_phys(&nm->db->signals[sig], phys);
+    return 0;
+}
+
+static int parse_hyst(const struct alarm_names *nm, int input, const char *s, int64_t *out) {
+    char *end;
+    double h = strtod(s, &end);
+
+    if (*s == '\0' || *end != '\0' || !(h >= 0))
+        return -1;
+    if (input < ALARM_IN_SENSOR) {
+        *out = (int64_t)h;
+        return 0;
+    }
+    double factor = fabs(nm->db->signals[nm->db->slot_signal[input - ALARM_IN_SENSOR]].factor);
+    *out = (int64_t)(h / factor + 0.5);
+    return 0;
+}
+
+// alarm <name> <input> <op> <value> [hyst=h] [and ...]... [debounce=ms]   (text= already cut off)
+// -1 if malformed, MISSING if it depends on a signal or limit the database lacks
+static int parse_rule(const struct alarm_names *nm, struct alarm_rule *r, char **tok, int n) {
+    if (n < 5 || strlen(tok[1]) >= sizeof(r->name))
+        return -1;
+    strcpy(r->name, tok[1]);
+
+    int i = 2;
+    for (;;) {
+        if (r->n_cond == ALARM_MAX_CONDS || i + 3 > n)
+            return -1;
+        struct alarm_cond *c = &r->cond[r->n_cond++];
+
+        int input = parse_input(nm, tok[i]);
+        if (input < 0)
+            return input;
+        c->input = input;
+
+        c->op = sizeof(op_names) / sizeof(op_names[0]);
+        for (uint8_t op = 0; op < sizeof(op_names) / sizeof(op_names[0]); op++)
+            if (strcmp(tok[i + 1], op_names[op]) == 0)
+                c->op = op;
+        if (c->op == sizeof(op_names) / sizeof(op_names[0]))
+            return -1;
+        int ret = parse_value(nm, input, tok[i + 2], &c->threshold);
+        if (ret < 0)
+            return ret;
+        i += 3;
+
+        if (i < n && strncmp(tok[i], "hyst=", 5) == 0) {
+            if (c->op >= OP_EQ || parse_hyst(nm, input, tok[i] + 5, &c->hyst) < 0)
+                return -1;
+            i++;
+        }
+        if (i < n && strcmp(tok[i], "and") == 0) {
+            i++;
+            continue;
+        }
+        break;
+    }
+
+    if (i < n && strncmp(tok[i], "debounce=", 9) == 0) {
+        char *end;
+        unsigned long ms = strtoul(tok[i] + 9, &end, 10);
+        if (tok[i][9] == '\0' || *end != '\0')
+            return -1;
+        r->debounce_us = (uint64_t)ms * 1000;
+        i++;
+    }
+    return (i == n) ? 0 : -1;
+}
+
+static int parse_text(const struct alarm_names *nm, const char *text, struct alarm_rule *rules, int *n_rules,
+                      int skip_missing) {
+    char line[256];
+    int lineno = 0;
+
+    *n_rules = 0;
+    while (*text) {
+        size_t len = strcspn(text, "\n");
+        lineno++;
+        if (len >= sizeof(line)) {
+            fprintf(stderr, "alarms: line %d too long\n", lineno);
+            return -1;
+        }
+        memcpy(line, text, len);
+        line[len] = '\0';
+        text += len + (text[len] == '\n');
+
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        // The message runs to the end of the line
+        struct alarm_rule r;
+        memset(&r, 0, sizeof(r));
+        char *msg = strstr(line, "text=");
+        if (msg != NULL) {
+            *msg = '\0';
+            snprintf(r.text, sizeof(r.text), "%s", msg + 5);
+        }
+
+        char *tok[ALARM_MAX_TOKENS];
+        int n = 0;
+        char *save;
+        for (char *t = strtok_r(line, " \t\r", &save); t && n < ALARM_MAX_TOKENS; t = strtok_r(NULL, " \t\r", &save))
+            tok[n++] = t;
+        if (n == 0)
+            continue;
+
+        int ret = (strcmp(tok[0], "alarm") != 0 || *n_rules == ALARM_MAX_RULES) ? -1 : parse_rule(nm, &r, tok, n);
+        if (ret == MISSING && skip_missing) {
+            fprintf(stderr, "alarms: rule %s skipped, its signal or limit is not in the database\n", tok[1]);
+            continue;
+        }
+        if (ret < 0) {
+            fprintf(stderr, "alarms: invalid rule on line %d\n", lineno);
+            return -1;
+        }
+        if (r.text[0] == '\0')
+            snprintf(r.text, sizeof(r.text), "%s", r.name);
+        rules[(*n_rules)++] = r;
+    }
+    return 0;
+}
+
+// ============ Evaluation ============
+static int cond_eval(struct alarm_cond *c, int64_t v) {
+    int64_t h = c->on ? c->hyst : 0;
+
+    switch (c->op) {
+    case OP_LT: return v <  c->threshold + h;
+    case OP_LE: return v <= c->threshold + h;
+    case OP_GT: return v >  c->threshold - h;
+    case OP_GE: return v >= c->threshold - h;
+    case OP_EQ: return v == c->threshold;
+    default:    return v != c->threshold;
+    }
+}
+
+static void rule_raise(struct alarm_set *set, int i, uint64_t now_us) {
+    struct alarm_rule *r = &set->rule[i];
+
+    set->active |= 1u << i;
+    set->raised++;
+    if (r->cause_us) {
+        uint64_t ref = r->cause_us + r->debounce_us;
+        hist_add(&set->raise_hist, (now_us > ref) ? now_us - ref : 0);
+        set->unshown |= 1u << i;
+    }
+}
+
+// Conditions on the inputs that are known; unknown inputs hold nothing
+static int rule_eval(struct alarm_set *set, int i, uint64_t t_us) {
+    struct alarm_rule *r = &set->rule[i];
+    int holds = 1;
+
+    for (int c = 0; c < r->n_cond; c++) {
+        struct alarm_cond *cd = &r->cond[c];
+        cd->on = set->known[cd->input] && cond_eval(cd, set->value[cd->input]);
+        holds &= cd->on;
+    }
+
+    if (holds == r->holds)
+        return 0;
+    r->holds = holds;
+
+    if (!holds) {
+        r->due_us = 0;
+        set->unshown &= ~(1u << i);
+        if (!(set->active & (1u << i)))
+            return 0;
+        set->active &= ~(1u << i);
+        return ALARM_CHANGED;
+    }
+
+    r->cause_us = t_us;
+    if (r->debounce_us == 0 || t_us == 0) {
+        rule_raise(set, i, t_us);
+        return ALARM_CHANGED;
+    }
+    r->due_us = t_us + r->debounce_us;
+    return ALARM_PENDING;
+}
+
+// ============ Public ============
+int alarm_init(struct alarm_set *set, uint32_t n_slots) {
+    memset(set, 0, sizeof(*set));
+    set->n_inputs = ALARM_IN_SENSOR + n_slots;
+    set->deps  = calloc(set->n_inputs, sizeof(*set->deps));
+    set->value = calloc(set->n_inputs, sizeof(*set->value));
+    set->known = calloc(set->n_inputs, sizeof(*set->known));
+    if (set->deps == NULL || set->value == NULL || set->known == NULL) {
+        perror("alarm inputs");
+        alarm_free(set);
+        return -1;
+    }
+    pthread_mutex_init(&set->lock, NULL);
+    return 0;
+}
+
+void alarm_free(struct alarm_set *set) {
+    free(set->deps);
+    free(set->value);
+    free(set->known);
+    set->deps  = NULL;
+    set->value = NULL;
+    set->known = NULL;
+    set->n_inputs = 0;
+}
+
+int alarm_compile(struct alarm_set *set, const char *text, const struct signal_db *db,
+                  const char *const *step_names, size_t n_steps, int skip_missing) {
+    const struct alarm_names nm = {db, set->n_inputs, step_names, n_steps};
+    struct alarm_rule *rules = calloc(ALARM_MAX_RULES, sizeof(*rules));
+    int n;
+
+    if (rules == NULL || parse_text(&nm, text, rules, &n, skip_missing) < 0) {
+        free(rules);
+        return -1;
+    }
+
+    pthread_mutex_lock(&set->lock);
+    memcpy(set->rule, rules, n * sizeof(*rules));
+    set->n_rules = n;
+    set->active  = 0;
+    set->unshown = 0;
+    memset(set->deps, 0, set->n_inputs * sizeof(*set->deps));
+    for (int i = 0; i < n; i++)
+        for (int c = 0; c < rules[i].n_cond; c++)
+            set->deps[rules[i].cond[c].input] |= 1u << i;
+
+    // Conditions that already hold are raised at once, outside the latency statistics
+    for (int i = 0; i < n; i++)
+        rule_eval(set, i, 0);
+    pthread_mutex_unlock(&set->lock);
+
+    free(rules);
+    return 0;
+}
+
+void alarm_begin(struct alarm_set *set) {
+    pthread_mutex_lock(&set->lock);
+}
+
+void alarm_end(struct alarm_set *set) {
+    pthread_mutex_unlock(&set->lock);
+}
+
+int alarm_update(struct alarm_set *set, int input, int64_t value, uint64_t t_us) {
+    if (input < 0 || (uint32_t)input >= set->n_inputs)
+        return 0;
+    if (set->known[input] && set->value[input] == value)
+        return 0;
+    set->value[input] = value;
+    set->known[input] = 1;
+
+    int result = 0;
+    for (uint32_t deps = set->deps[input]; deps; deps &= deps - 1)
+        result |= rule_eval(set, __builtin_ctz(deps), t_us);
+    return result;
+}
+
+int alarm_tick(struct alarm_set *set, uint64_t now_us) {
+    int result = 0;
+
+    pthread_mutex_lock(&set->lock);
+    for (int i = 0; i < set->n_rules; i++) {
+        struct alarm_rule *r = &set->rule[i];
+        if (r->due_us && r->due_us <= now_us) {
+            r->due_us = 0;
+            rule_raise(set, i, now_us);
+            result = ALARM_CHANGED;
+        }
+    }
+    pthread_mutex_unlock(&set->lock);
+    return result;
+}
+
+uint64_t alarm_deadline(struct alarm_set *set) {
+    uint64_t due = UINT64_MAX;
+
+    pthread_mutex_lock(&set->lock);
+    for (int i = 0; i < set->n_rules; i++)
+        if (set->rule[i].due_us && set->rule[i].due_us < due)
+            due = set->rule[i].due_us;
+    pthread_mutex_unlock(&set->lock);
+    return due;
+}
+
+uint32_t alarm_active(struct alarm_set *set) {
+    pthread_mutex_lock(&set->lock);
+    uint32_t active = set->active;
+    pthread_mutex_unlock(&set->lock);
+    return active;
+}
+
+void alarm_shown(struct alarm_set *set, uint64_t now_us) {
+    pthread_mutex_lock(&set->lock);
+    for (uint32_t m = set->unshown; m; m &= m - 1) {
+        const struct alarm_rule *r = &set->rule[__builtin_ctz(m)];
+        uint64_t ref = r->cause_us + r->debounce_us;
+        hist_add(&set->show_hist, (now_us > ref) ? now_us - ref : 0);
+    }
+    set->unshown = 0;
+    pthread_mutex_unlock(&set->lock);
+}
+
+int alarm_describe(struct alarm_set *set, int rule, char *text, size_t len) {
+    int input = -1;
+
+    pthread_mutex_lock(&set->lock);
+    if (rule >= 0 && rule < set->n_rules) {
+        snprintf(text, len, "%s", set->rule[rule].text);
+        input = set->rule[rule].cond[0].input;
+    }
+    pthread_mutex_unlock(&set->lock);
+    return input;
+}
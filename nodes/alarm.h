@@ -0,0 +1,123 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "histogram.h"
+#include "signal_db.h"
+
+/*
+ * Alarm rules, compiled from text against the signal database.
+ *
+ *   # alarm <name> <cond> [and <cond>]... [debounce=<ms>] [text=<message to the end of the line>]
+ *   # cond: <input> <op> <value> [hyst=<h>]
+ *   alarm overheat      coolant_temp > hi hyst=1 text=OVERHEATING!
+ *   alarm door_running  engine == running and door == 0 debounce=500 text=Door open while running
+ *
+ * Inputs are the database signals, one per slot (physical units, or
+ * lo / hi for the signal's database limit) and the vehicle flags
+ * left_ind, right_ind, headlight, engine, door, seatbelt (engine takes
+ * its step names). Operators: < <= > >= == !=.
+ *
+ * Thresholds and hysteresis are converted to raw units at compile time.
+ * A condition turns on past its threshold and off only once it is back
+ * by the hysteresis. A rule whose conditions all hold is raised after
+ * holding for its debounce time (at once without one) and cleared as
+ * soon as one condition drops.
+ *
+ * Each input has a bitmask of the rules that reference it, so an update
+ * re-evaluates only those, and not at all if the value did not change.
+ * Writers bracket updates with alarm_begin() / alarm_end(); debounce
+ * deadlines are driven through alarm_deadline() / alarm_tick().
+ *
+ * Latency is taken from the time of the input that completed a rule
+ * (the frame's kernel receive time for signals), net of its debounce,
+ * to the moment it was raised and to the moment it was shown.
+ */
+
+#define ALARM_MAX_RULES  32     // active set is a bitmask
+#define ALARM_MAX_CONDS  4
+#define ALARM_NAME_LEN   24
+#define ALARM_TEXT_LEN   48
+#define ALARM_MAX_TOKENS 32
+
+// Inputs: vehicle flags, then one per slot of the signal database
+#define ALARM_IN_LEFT_IND   0
+#define ALARM_IN_RIGHT_IND  1
+#define ALARM_IN_HEADLIGHT  2
+#define ALARM_IN_ENGINE     3
+#define ALARM_IN_DOOR       4
+#define ALARM_IN_SEATBELT   5
+#define ALARM_IN_SENSOR     8   // + slot
+
+// alarm_update() / alarm_tick() results
+#define ALARM_CHANGED  1        // the active set changed
+#define ALARM_PENDING  2        // a debounce deadline was set
+
+struct alarm_cond {
+    uint32_t input;
+    uint8_t op;
+    uint8_t on;                 // current state, with hysteresis
+    int64_t threshold;          // raw units
+    int64_t hyst;               // raw units, >= 0
+};
+
+struct alarm_rule {
+    char     name[ALARM_NAME_LEN];
+    char     text[ALARM_TEXT_LEN];
+    struct alarm_cond cond[ALARM_MAX_CONDS];
+    uint8_t  n_cond;
+    uint8_t  holds;             // every condition is on
+    uint64_t debounce_us;
+    uint64_t cause_us;          // input time that made it hold
+    uint64_t due_us;            // raise time while debouncing, 0 otherwise
+};
+
+struct alarm_set {
+    pthread_mutex_t lock;
+
+    struct alarm_rule rule[ALARM_MAX_RULES];
+    int n_rules;
+
+    // By input, ALARM_IN_SENSOR + the database's slots of them
+    uint32_t n_inputs;
+    uint32_t *deps;                 // rules referencing each input
+    int64_t *value;
+    uint8_t *known;
+
+    uint32_t active;
+    uint32_t unshown;               // raised since the last alarm_shown()
+
+    // Latency, input to raise and input to display (us)
+    struct histogram raise_hist, show_hist;
+    uint64_t raised;
+};
+
+extern const char alarm_default_text[];
+
+// Parses and compiles text; on error keeps the previous rules and returns -1.
+// Input values are kept, rule states start over. step_names name the engine values.
+// skip_missing (for alarm_default_text) leaves out, with a warning, rules on a signal
+// or limit the database does not define instead of failing
+int  alarm_compile(struct alarm_set *set, const char *text, const struct signal_db *db,
+                   const char *const *step_names, size_t n_steps, int skip_missing);
+// Inputs for n_slots signal slots; -1 on allocation failure
+int  alarm_init(struct alarm_set *set, uint32_t n_slots);
+void alarm_free(struct alarm_set *set);
+
+void alarm_begin(struct alarm_set *set);
+void alarm_end(struct alarm_set *set);
+int  alarm_update(struct alarm_set *set, int input, int64_t value, uint64_t t_us);  // between begin / end
+
+// Debounce expiry; both take the lock
+int      alarm_tick(struct alarm_set *set, uint64_t now_us);
+uint64_t alarm_deadline(struct alarm_set *set);     // UINT64_MAX if nothing is pending
+
+uint32_t alarm_active(struct alarm_set *set);
+// Alarms raised so far are now visible; records their display latency
+void alarm_shown(struct alarm_set *set, uint64_t now_us);
+// Text and first input of a rule; -1 if there is no such rule
+int  alarm_describe(struct alarm_set *set, int rule, char *text, size_t len);
+
+#endif
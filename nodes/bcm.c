@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include "can_header.h"
 #include "can_utils.h"
+#include "e2e.h"
 
 #define BLINK_ON_TIME   500000
 #define BLINK_OFF_TIME  500000
@@ -21,6 +22,9 @@ int can_socket;
 int ind_state;
 int hl_state;
 
+const struct e2e_profile *cmd_profile;
+struct e2e_rx_state cmd_rx;
+
 struct gpiod_chip *gpio_chip;
 struct gpiod_line *right_ind_gpio;
 struct gpiod_line *left_ind_gpio;
@@ -28,6 +32,8 @@ struct gpiod_line *headlight_gpio;
 
 static int initialize_gpio(void);
 static void handle_can_event(void);
+static void report_rejection(int err, const struct can_frame *cmd);
+static void apply_lamp_word(uint8_t lamps, uint8_t mask);
 static void update_outputs(int blink_val);
 static void cleanup(void);
 
@@ -71,7 +77,23 @@ static void handle_can_event(void) {
   if (nbytes < 1)
     return;
 
+  // Command words carry an alive counter + CRC-16; reject corrupted or stale ones
+  // and tell the dashboard, with the lamps as they stay. Sync frames only set the counter.
   uint8_t cmd = frame.data[0];
+  if (cmd == BCM_CMD_WORD || cmd == E2E_SYNC) {
+    int err = e2e_check(cmd_profile, &cmd_rx, frame.data, frame.can_dlc);
+    if (err < 0) {
+      fprintf(stderr, "BCM command rejected: %s\n", e2e_strerror(err));
+      report_rejection(err, &frame);
+      return;
+    }
+    if (err == E2E_SYNCED)
+      return;
+    apply_lamp_word(frame.data[1], frame.data[2]);
+    return;
+  }
+
+  // Legacy single-lamp opcodes
   switch (cmd)
   {
     case LI_ON: ind_state = 1; break;
@@ -84,6 +106,24 @@ static void handle_can_event(void) {
   }
 }
 
+static void report_rejection(int err, const struct can_frame *cmd) {
+  struct can_frame report = {.can_id = E2E_REPORT_CAN_ID};
+  uint8_t lamps = ind_state | (hl_state ? LAMP_HEAD : 0);
+
+  report.can_dlc = e2e_report_encode(cmd_profile, err, cmd->data, cmd->can_dlc, lamps, report.data);
+  if (write(can_socket, &report, sizeof(report)) != sizeof(report))
+    perror("CAN report write failed");
+}
+
+// ind_state uses the same bits as LAMP_LEFT / LAMP_RIGHT (3 = hazard)
+static void apply_lamp_word(uint8_t lamps, uint8_t mask) {
+  uint8_t current = ind_state | (hl_state ? LAMP_HEAD : 0);
+
+  current   = (current & ~mask) | (lamps & mask);
+  ind_state = current & LAMP_IND;
+  hl_state  = (current & LAMP_HEAD) ? 1 : 0;
+}
+
 static void update_outputs(int blink_val) {
   int r = 0, l = 0, h = 0;
 
@@ -125,6 +165,9 @@ int main(int argc, char *argv[]) {
   int nfds = 1;
   int ret;
 
+  e2e_init();
+  cmd_profile = e2e_profile_lookup(BCM_CAN_ID);
+
   struct can_filter bcm_filter[1] = {
     {.can_id = BCM_CAN_ID, .can_mask = CAN_SFF_MASK}
   };
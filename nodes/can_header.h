@@ -7,16 +7,35 @@
 #define HL_OFF 0x20 // Headlight OFF
 #define EN_ON 0x08 // Engine
 #define EN_OFF 0x00 // Engine OFF
-#define DR 0x10 // Door
-#define SB 0x20 // Seat Belt
+#define DR 0x10 // Door (status code, never sent to BCM_CAN_ID)
+#define SB 0x20 // Seat Belt (status code, never sent to BCM_CAN_ID)
+
+//BCM command word: data[1] = lamp states, data[2] = mask of lamps to change
+#define BCM_CMD_WORD 0x80 // data[0], outside the legacy opcode range
+#define LAMP_LEFT 0x01 // Left Indicator
+#define LAMP_RIGHT 0x02 // Right Indicator
+#define LAMP_HEAD 0x04 // Headlight
+#define LAMP_IND (LAMP_LEFT | LAMP_RIGHT)
+
+//E2E_REPORT_CAN_ID payload (e2e_report_encode): data[4] = BCM lamp word, or 1 if the engine runs
+
+//ENV_MUX_CAN_ID pages
+#define ENV_PAGE_CLIMATE 0x00 // ambient + cabin temperature
+#define ENV_PAGE_FLUIDS 0x01 // fuel level + oil pressure
+
+//ENGINE_DATA_CAN_ID payload, big-endian: data[0..1] = rpm, data[2..3] = battery voltage in mV
+#define ENGINE_DATA_PERIOD_MS 10 // 100 Hz
 
 //Vcan interface
 #define CAN_INF "vcan5"
 
 //node ids
 #define COOLANT_CAN_ID 0x080
+#define ENGINE_DATA_CAN_ID 0x090 // rpm + battery voltage, sent by the engine node
 #define TYRE_PR_CAN_ID 0x099
+#define ENV_MUX_CAN_ID 0x0A0 // multiplexed, data[0] = page
 #define BCM_CAN_ID 0x101
 #define ENGINE_CAN_ID 0x102
 #define DOOR_CAN_ID 0x103
 #define SEATBELT_CAN_ID 0x104
+#define E2E_REPORT_CAN_ID 0x105 // rejected commands, sent by the BCM and engine nodes
@@ -0,0 +1,1199 @@
+/*
+ * dashboard.c - Dashboard core
+ * Display, sensor decoding, command transmit and the engine safety checks,
+ * shared by dashboard_thread, dashboard_reactor and dashboard_daemon.
+ */
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include "can_utils.h"
+#include "can_header.h"
+#include "signal_codec.h"
+#include "dashboard.h"
+#include "state_proto.h"
+
+/* ============ Shared State ============ */
+int can_socket, rtr_socket;
+int db_watch_fd = -1;
+int max_fps = DEFAULT_MAX_FPS;
+const char *state_socket_path = SS_DEFAULT_SOCKET;
+
+struct vehicle_state_pub *vehicle;
+const char *state_page_name = VS_PAGE_NAME;
+static struct vehicle_state_page *state_page;
+static struct vehicle_state_pub *private_state;    // if the page cannot be created
+struct signal_watch sensor_watch;
+struct signal_history sensor_history;
+struct filter_bank sensor_filter;
+struct alarm_set dash_alarms;
+const char *alarm_path = NULL;
+struct deadline_monitor sensor_deadlines;
+
+struct e2e_tx_state engine_tx, bcm_tx;
+
+// Engine state from the engine node's last rejection report, -1 if none; the engine
+// state machine takes it, in whichever thread runs that
+static atomic_int engine_reported = -1;
+
+int secoc_enabled = 0;
+struct secoc_key secoc_key;
+struct secoc_tx_state engine_sec_tx;
+static struct secoc_rx_state door_sec_rx, seatbelt_sec_rx;
+
+// Last door / seat belt status heard; only touched by whoever reads rtr_socket
+static struct rtr_cache status_cache;
+static uint32_t lease_ms = DEFAULT_LEASE_MS;
+
+// Per-node round-trip history behind the RTR deadlines
+static struct rtr_timing rtr_timing;
+static uint32_t rtr_floor_ms = RTR_FLOOR_MS, rtr_ceiling_ms = RTR_TIMEOUT_MS;
+
+struct screen dash_screen;
+
+// Keypress-to-wire latency per menu option
+struct latency cmd_latency;
+static const char *const option_names[LAT_MAX_CMDS] = {
+    [1] = "Left Indicator",  [2] = "Right Indicator", [3] = "Hazard Light",
+    [4] = "Indicator OFF",   [5] = "Headlight ON",    [6] = "Headlight OFF",
+    [7] = "Start Engine",    [8] = "Stop Engine",     [9] = "Hazard + Headlight",
+};
+
+// Application slots of the signal database, fixed by the first one loaded
+static uint32_t slot_count, slot_words;
+
+// Slots written since the rendering (or publishing) context last took them. Writers mark
+// them inside their write section and the set is taken before the snapshot, so a taken
+// slot's value is in that snapshot; one marked after is simply read again next time
+static _Atomic uint64_t *slots_written;
+static uint64_t *slots_taken;
+static struct vehicle_state *snapshot;
+
+// Inside a vehicle state write section
+static void slot_written(uint32_t slot) {
+    atomic_fetch_or(&slots_written[slot / 64], 1ull << (slot % 64));
+}
+
+// ============ Dashboard Display ============ 
+#define BLINK_RED   (SCR_BLINK | SCR_BOLD | SCR_RED)
+#define BOLD_GREEN  (SCR_BOLD | SCR_GREEN)
+#define DB_LIMITS   .warn_lo = NAN, .warn_hi = NAN
+
+// Menu, status lines, sensor lines, then the alarm, notice and prompt lines
+static const struct widget dash_widgets[] = {
+    {WIDGET_TEXT,  0, 0, DASH_COLS, -1, .label = "=========== Dashboard ============"},
+    {WIDGET_TEXT,  1, 0, DASH_COLS, -1, .label = "1. Left Indicator"},
+    {WIDGET_TEXT,  2, 0, DASH_COLS, -1, .label = "2. Right Indicator"},
+    {WIDGET_TEXT,  3, 0, DASH_COLS, -1, .label = "3. Hazard Light"},
+    {WIDGET_TEXT,  4, 0, DASH_COLS, -1, .label = "4. Indicator OFF"},
+    {WIDGET_TEXT,  5, 0, DASH_COLS, -1, .label = "5. Headlight ON"},
+    {WIDGET_TEXT,  6, 0, DASH_COLS, -1, .label = "6. Headlight OFF"},
+    {WIDGET_TEXT,  7, 0, DASH_COLS, -1, .label = "7. Start Engine"},
+    {WIDGET_TEXT,  8, 0, DASH_COLS, -1, .label = "8. Stop Engine"},
+    {WIDGET_TEXT,  9, 0, DASH_COLS, -1, .label = "9. Hazard + Headlight"},
+    {WIDGET_TEXT, 10, 0, DASH_COLS, -1, .label = "0. Exit"},
+    {WIDGET_TEXT, 11, 0, DASH_COLS, -1, .label = "==================================="},
+
+    {WIDGET_FLAG,   12,  0, 13, WIDGET_LEFT_IND,  .arg = 1, .label = "Indicator: ", .text = {"<=", "<="},
+     .attr = {SCR_WHITE, SCR_BLINK | SCR_BOLD | SCR_YELLOW}},
+    {WIDGET_FLAG,   12, 13,  5, WIDGET_RIGHT_IND, .arg = 1, .label = " ● ", .text = {"=>", "=>"},
+     .attr = {SCR_WHITE, SCR_BLINK | SCR_BOLD | SCR_YELLOW}},
+    {WIDGET_FLAG,   13,  0, 20, WIDGET_HEADLIGHT, .arg = 1, .label = "Headlight: ", .text = {"⚪", "🟡"},
+     .attr = {SCR_WHITE, SCR_WHITE}},
+    {WIDGET_FLAG,   14,  0, 20, WIDGET_DOOR,      .arg = 1, .label = "Door: ", .text = {"Open", "Closed"},
+     .attr = {BLINK_RED, BOLD_GREEN}},
+    {WIDGET_FLAG,   15,  0, 30, WIDGET_SEATBELT,  .arg = 1, .label = "Seat Belt: ", .text = {"Not Fastened", "Fastened"},
+     .attr = {BLINK_RED, BOLD_GREEN}},
+    {WIDGET_ENGINE, 16,  0, 30, -1, .arg = ENG_RUNNING, .label = "Engine: ", .text = {"OFF", "ON"},
+     .attr = {SCR_BOLD | SCR_RED, BOLD_GREEN, SCR_BOLD | SCR_YELLOW}},
+    {WIDGET_VALUE,  16, 30, 16, -1, .signal = "engine_rpm",      .label = "RPM: ",     .text = {NULL, "---"},
+     .attr = {SCR_BOLD, BLINK_RED}, DB_LIMITS},
+    {WIDGET_VALUE,  16, 46, 20, -1, .signal = "battery_voltage", .label = "Battery: ", .text = {" V", "--.--"},
+     .attr = {BOLD_GREEN, BLINK_RED}, DB_LIMITS},
+
+    // Values turn attr[1] outside their limits; a stale one is greyed out
+    {WIDGET_VALUE,  17,  0, 26, -1, .signal = "coolant_temp", .label = "Coolant Temp: ", .text = {" °C :"},
+     .attr = {SCR_BOLD | SCR_YELLOW, SCR_BOLD | SCR_RED}, DB_LIMITS},
+    {WIDGET_STATUS, 17, 26, TREND_COL - 26, -1, .signal = "coolant_temp", .text = {"NORMAL"}, .attr = {BOLD_GREEN, BLINK_RED}},
+    {WIDGET_TREND,  17, TREND_COL, DASH_COLS - TREND_COL, -1, .signal = "coolant_temp", .arg = 1},
+    {WIDGET_VALUE,  18,  0, 26, -1, .signal = "tyre_pressure", .label = "Tyre Pressure: ", .text = {" PSI", "--.-"},
+     .attr = {BOLD_GREEN, BLINK_RED}, DB_LIMITS},
+    {WIDGET_STATUS, 18, 26, TREND_COL - 26, -1, .signal = "tyre_pressure", .attr = {0, BLINK_RED}},
+    {WIDGET_TREND,  18, TREND_COL, DASH_COLS - TREND_COL, -1, .signal = "tyre_pressure", .arg = 0},
+    {WIDGET_VALUE,  19,  0, 19, -1, .signal = "ambient_temp", .label = "Ambient: ", .text = {" °C"},  DB_LIMITS},
+    {WIDGET_VALUE,  19, 19, 19, -1, .signal = "cabin_temp",   .label = "  Cabin: ", .text = {" °C"},  DB_LIMITS},
+    {WIDGET_VALUE,  20,  0, 15, -1, .signal = "fuel_level",   .label = "Fuel: ",    .text = {" %"},   DB_LIMITS},
+    {WIDGET_VALUE,  20, 15, 19, -1, .signal = "oil_pressure", .label = "  Oil: ",   .text = {" kPa"}, DB_LIMITS},
+
+    // Alarms the sensor lines do not show share one line
+    {WIDGET_ALARMS, 21, 0, DASH_COLS, -1, .label = "WARNING:", .attr = {0, BLINK_RED}},
+    {WIDGET_NOTICE, 22, 0, DASH_COLS, -1, .attr = {SCR_BOLD | SCR_RED}},
+    {WIDGET_TEXT,   PROMPT_ROW, 0, DASH_COLS, -1, .label = PROMPT_TEXT},
+};
+
+struct layout dash_layout;
+
+// Widgets read a signal through its application slot in the published state
+static int slot_value(const struct vehicle_state *vs, const struct signal_db *db, int32_t sig,
+                      int32_t *raw, int *stale) {
+    int32_t slot = db->slot[sig];
+
+    if (slot < 0 || (uint32_t)slot >= vs->n_slots)
+        return 0;
+    *raw   = vs->sensor[slot].raw;
+    *stale = vs->sensor[slot].stale;
+    return 1;
+}
+
+// ============ Frame ============
+const struct vehicle_state *dashboard_snapshot(const uint64_t **changed) {
+    for (uint32_t w = 0; w < slot_words; w++)
+        slots_taken[w] = atomic_load_explicit(&slots_written[w], memory_order_relaxed)
+                       ? atomic_exchange(&slots_written[w], 0) : 0;
+    vehicle_state_read(vehicle, snapshot);
+    *changed = slots_taken;
+    return snapshot;
+}
+
+// Redraws the widgets whose inputs changed; only changed cells reach the terminal
+void dashboard_redraw(void) {
+    struct screen *scr = &dash_screen;
+    const uint64_t *changed;
+    int token;
+
+    // One consistent copy; writers are never held up by the render
+    const struct vehicle_state *vs = dashboard_snapshot(&changed);
+    const struct signal_db *db = signal_db_acquire(&token);
+    layout_render(&dash_layout, scr, vs, db, changed, monotonic_us());
+    signal_db_release(token);
+
+    screen_cursor(scr, PROMPT_ROW, sizeof(PROMPT_TEXT) - 1);
+    screen_flush(scr, STDOUT_FILENO);
+    alarm_shown(&dash_alarms, monotonic_us());
+}
+
+uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Replaces the notice line; workers must not print into the frame directly
+void dashboard_notice(const char *fmt, ...) {
+    char text[VS_NOTICE_LEN];
+    va_list ap;
+
+    // Format outside the write section, which stays a plain copy
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    struct vehicle_state *vs = vehicle_state_write_begin(vehicle);
+    memcpy(vs->notice, text, sizeof(text));
+    vehicle_state_write_end(vehicle);
+
+    request_redraw();
+}
+
+// ============ Alarms ============
+// A changed active set goes to the vehicle state; a new debounce deadline only needs
+// the model to wake and re-read dashboard_alarm_deadline()
+static void alarms_publish(int result) {
+    if (result & ALARM_CHANGED) {
+        uint32_t active = alarm_active(&dash_alarms);
+        vehicle_state_write_begin(vehicle)->alarms = active;
+        vehicle_state_write_end(vehicle);
+    }
+    if (result)
+        request_redraw();
+}
+
+static void alarm_input(int input, int64_t value, uint64_t t_us) {
+    alarm_begin(&dash_alarms);
+    int result = alarm_update(&dash_alarms, input, value, t_us);
+    alarm_end(&dash_alarms);
+    alarms_publish(result);
+}
+
+// Rules file (or the defaults) against the current database; -1 keeps the previous rules
+static int alarms_load(void) {
+    char *text = NULL;
+    const char *steps[ENG_STOPPING + 1];
+    int token;
+
+    if (alarm_path != NULL) {
+        FILE *fp = fopen(alarm_path, "r");
+        if (fp == NULL) {
+            perror("Alarm rules open failed");
+            return -1;
+        }
+        fseek(fp, 0, SEEK_END);
+        long size = ftell(fp);
+        rewind(fp);
+        text = (size >= 0) ? malloc(size + 1) : NULL;
+        if (text == NULL || fread(text, 1, size, fp) != (size_t)size) {
+            fprintf(stderr, "%s: read failed\n", alarm_path);
+            fclose(fp);
+            free(text);
+            return -1;
+        }
+        text[size] = '\0';
+        fclose(fp);
+    }
+
+    for (int i = 0; i <= ENG_STOPPING; i++)
+        steps[i] = engine_state_name(i);
+
+    int ret = alarm_compile(&dash_alarms, text ? text : alarm_default_text, signal_db_acquire(&token),
+                            steps, ENG_STOPPING + 1, text == NULL);
+    signal_db_release(token);
+    free(text);
+    alarms_publish(ALARM_CHANGED);
+    return ret;
+}
+
+uint64_t dashboard_alarm_deadline(void) {
+    return alarm_deadline(&dash_alarms);
+}
+
+void dashboard_alarm_tick(uint64_t now_us) {
+    alarms_publish(alarm_tick(&dash_alarms, now_us));
+}
+
+// ============ Deadline Monitoring ============
+// Stale slots as published and as the monitor has them now; both only inside write sections
+static uint64_t *stale_shown, *stale_now;
+
+// Inside a write section: slots whose staleness moved are flipped and marked written
+static void stale_apply(struct vehicle_state *vs) {
+    deadline_stale(&sensor_deadlines, stale_now, slot_words);
+    for (uint32_t w = 0; w < slot_words; w++) {
+        for (uint64_t moved = stale_now[w] ^ stale_shown[w]; moved; moved &= moved - 1) {
+            uint32_t slot = w * 64 + __builtin_ctzll(moved);
+            vs->sensor[slot].stale = (stale_now[w] >> (slot % 64)) & 1;
+            slot_written(slot);
+        }
+        stale_shown[w] = stale_now[w];
+    }
+}
+
+static void stale_publish(void) {
+    stale_apply(vehicle_state_write_begin(vehicle));
+    vehicle_state_write_end(vehicle);
+    request_redraw();
+}
+
+// Monitored ids as reported: pages carry their selector above the CAN id
+#define MONITOR_PAGE  0x80000000u
+
+// Re-arms every deadline against a database version newer than the monitor's
+static void deadlines_configure(const struct signal_db *db) {
+    struct deadline_spec *spec = calloc(db->n_monitors ? db->n_monitors : 1, sizeof(*spec));
+    if (spec == NULL)
+        return;
+
+    for (uint32_t i = 0; i < db->n_monitors; i++) {
+        const struct signal_db_monitor *m = &db->monitors[i];
+        spec[i].id = m->can_id | ((m->page >= 0) ? MONITOR_PAGE | (uint32_t)m->selector << 16 : 0);
+        spec[i].bits = &db->monitor_slots[m->first_slot];
+        spec[i].n = m->n_slots;
+        spec[i].timeout_ms = m->timeout_ms;
+    }
+    if (deadline_configure(&sensor_deadlines, spec, db->n_monitors, slot_count, db->generation,
+                           monotonic_us()) > 0)
+        stale_publish();
+    free(spec);
+}
+
+struct expiry {
+    int count;
+    struct deadline_entry first;
+};
+
+static void deadline_expired(const struct deadline_entry *e, void *ctx) {
+    struct expiry *x = ctx;
+
+    if (x->count++ == 0)
+        x->first = *e;
+}
+
+uint64_t dashboard_monitor_deadline(void) {
+    return deadline_next(&sensor_deadlines);
+}
+
+// Overdue messages turn their slots stale and name themselves on the notice line
+void dashboard_monitor_tick(uint64_t now_us) {
+    struct expiry x = {0};
+
+    if (deadline_tick(&sensor_deadlines, now_us, deadline_expired, &x) == 0)
+        return;
+
+    char what[24];
+    uint32_t id = x.first.id;
+    if (id & MONITOR_PAGE)
+        snprintf(what, sizeof(what), "0x%03X page %u", id & CAN_SFF_MASK, (id >> 16) & 0xFF);
+    else
+        snprintf(what, sizeof(what), "0x%03X", id & CAN_SFF_MASK);
+
+    stale_publish();
+    if (x.count > 1)
+        dashboard_notice("Timeout: No frames from %s in %u ms (+%d more)", what, x.first.timeout_us / 1000, x.count - 1);
+    else
+        dashboard_notice("Timeout: No frames from %s in %u ms", what, x.first.timeout_us / 1000);
+}
+
+// ============ Receive ============
+// Values decoded and bursts read, by whoever reads can_socket; compared with the
+// frames drawn they show how far high-rate channels are decimated for display
+static uint64_t rx_samples, rx_bursts;
+
+// Kernel receive time on the monotonic clock, so frames read late keep their real age
+static uint64_t rx_time_us(struct msghdr *msg) {
+    uint64_t now = monotonic_us();
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMP)
+            continue;
+
+        struct timeval tv;
+        struct timespec real;
+        memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+        clock_gettime(CLOCK_REALTIME, &real);
+
+        uint64_t rx_real  = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+        uint64_t now_real = (uint64_t)real.tv_sec * 1000000 + real.tv_nsec / 1000;
+        if (rx_real <= now_real && now_real - rx_real < now)
+            return now - (now_real - rx_real);
+    }
+    return now;
+}
+
+// One frame from can_socket and its receive time. Our own transmissions come back flagged
+// MSG_CONFIRM (CAN_RAW_RECV_OWN_MSGS) and only confirm a command.
+// Returns 1 for a bus frame, 0 for a confirmation, -1 if nothing was read
+static int can_recv(struct can_frame *frame, uint64_t *rx_us, int flags) {
+    char control[CMSG_SPACE(sizeof(struct timeval))];
+    struct iovec iov = {.iov_base = frame, .iov_len = sizeof(*frame)};
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control, .msg_controllen = sizeof(control),
+    };
+
+    if (recvmsg(can_socket, &msg, flags) != sizeof(*frame))
+        return -1;
+    *rx_us = rx_time_us(&msg);
+    if (msg.msg_flags & MSG_CONFIRM) {
+        latency_confirm(&cmd_latency, frame, *rx_us);
+        return 0;
+    }
+    return 1;
+}
+
+// ============ Sensor Decoding ============ 
+// Called from signal_watch_flush() inside a vehicle state write section; ctx is the state
+static void sensor_changed(int slot, int64_t value, int64_t previous, void *ctx) {
+    struct vehicle_state *vs = ctx;
+    (void)previous;
+
+    vs->sensor[slot].raw = (int32_t)value;
+    slot_written(slot);
+}
+
+// Slots with a sample waiting for the filter step, each once (a second sample steps the
+// filters first); only touched by whoever reads can_socket
+static uint32_t *filter_waiting;
+static uint32_t n_waiting;
+
+// The watch sees the smoothed values of the slots a filter step took
+static void sensor_filter_watch(void) {
+    for (uint32_t i = 0; i < n_waiting; i++)
+        signal_watch_update(&sensor_watch, filter_waiting[i], filter_bank_get(&sensor_filter, filter_waiting[i]));
+    n_waiting = 0;
+}
+
+// Last filter step of the burst, for the samples still waiting
+static void sensor_filter_step(void) {
+    if (n_waiting == 0)
+        return;
+    filter_bank_step(&sensor_filter);
+    sensor_filter_watch();
+}
+
+// O(1) id lookup; multiplexed messages go through the page dispatch table.
+// The message (and page) meet their deadline if mon is given, *fresh is set if one was stale.
+// Every value goes to the history and the alarms, stamped with the frame's receive
+// time, and into its slot's filter, which then has a sample waiting.
+// A slot sampled twice in one burst steps the filters first, so every sample is filtered.
+static int sensor_decode(const struct signal_db *db, const struct can_frame *frame, uint64_t rx_us,
+                         struct deadline_monitor *mon, int *fresh) {
+    const struct signal_db_message *msg = signal_db_message(db, frame->can_id & CAN_SFF_MASK);
+    if (msg == NULL || (frame->can_id & CAN_RTR_FLAG))
+        return 0;
+    if (mon != NULL && msg->monitor >= 0)
+        *fresh |= deadline_kick(mon, msg->monitor, rx_us);
+
+    const struct can_signal *sig = &db->signals[msg->first];
+    size_t count = msg->count;
+
+    if (msg->mux) {
+        const struct can_mux_page *page = can_mux_decode(msg->mux, frame->data);
+        if (page == NULL)
+            return 0;
+        if (mon != NULL && db->page_monitor[page - db->pages] >= 0)
+            *fresh |= deadline_kick(mon, db->page_monitor[page - db->pages], rx_us);
+        sig   = page->signals;
+        count = page->count;
+    }
+
+    int alarms = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t slot = db->slot[&sig[i] - db->signals];
+        if (slot < 0)
+            continue;
+        int64_t raw = signal_extract_raw(&sig[i], frame->data);
+        if (filter_bank_add(&sensor_filter, slot, (int32_t)raw))
+            sensor_filter_watch();
+        filter_waiting[n_waiting++] = slot;
+        signal_history_add(&sensor_history, slot, rx_us, (int32_t)raw);
+        rx_samples++;
+        alarms |= alarm_update(&dash_alarms, ALARM_IN_SENSOR + slot, raw, rx_us);
+    }
+    return alarms;
+}
+
+static void apply_deadbands(const struct signal_db *db) {
+    for (uint32_t slot = 0; slot < slot_count; slot++) {
+        int32_t sig = db->slot_signal[slot];
+        signal_watch_set_deadband(&sensor_watch, slot, (sig >= 0) ? db->records[sig].deadband : 0);
+    }
+}
+
+// Filters of the bank in use, per slot
+static struct filter_spec *filter_current;
+
+// Filters are rebuilt (and primed again) only if the database changed them
+static void apply_filters(const struct signal_db *db) {
+    struct filter_spec *spec = malloc(slot_count * sizeof(*spec));
+    int same = 1;
+
+    if (spec == NULL) {
+        perror("filter bank failed");
+        return;
+    }
+    for (uint32_t slot = 0; slot < slot_count; slot++) {
+        int32_t sig = db->slot_signal[slot];
+        spec[slot].kind  = (sig >= 0) ? db->records[sig].filter : FILTER_NONE;
+        spec[slot].param = (sig >= 0) ? db->records[sig].filter_param : 0;
+        same &= spec[slot].kind == filter_current[slot].kind && spec[slot].param == filter_current[slot].param;
+    }
+
+    struct filter_bank bank;
+    if (!same && filter_bank_init(&bank, spec, slot_count) < 0)
+        perror("filter bank failed");
+    else if (!same) {
+        filter_bank_free(&sensor_filter);
+        sensor_filter = bank;
+        memcpy(filter_current, spec, slot_count * sizeof(*spec));
+    }
+    free(spec);
+}
+
+// ============ Command Rejections ============
+// Lamps as the BCM has them (mask: the ones to set), to the display and the alarms
+static void lamps_publish(uint8_t lamps, uint8_t mask, uint64_t t_us) {
+    struct vehicle_state *vs = vehicle_state_write_begin(vehicle);
+    if (mask & LAMP_LEFT)  vs->left_ind  = (lamps & LAMP_LEFT)  ? 1 : 0;
+    if (mask & LAMP_RIGHT) vs->right_ind = (lamps & LAMP_RIGHT) ? 1 : 0;
+    if (mask & LAMP_HEAD)  vs->headlight = (lamps & LAMP_HEAD)  ? 1 : 0;
+    struct vehicle_state lamp = *vs;
+    vehicle_state_write_end(vehicle);
+    request_redraw();
+
+    alarm_input(ALARM_IN_LEFT_IND,  lamp.left_ind,  t_us);
+    alarm_input(ALARM_IN_RIGHT_IND, lamp.right_ind, t_us);
+    alarm_input(ALARM_IN_HEADLIGHT, lamp.headlight, t_us);
+}
+
+// A node refused a command: the display goes back to what the node reports it has
+static void command_rejected(const struct e2e_report *r, uint64_t t_us) {
+    if (r->can_id == BCM_CAN_ID) {
+        dashboard_notice("Lamp command rejected by BCM: %s", e2e_strerror(r->err));
+        lamps_publish(r->state, LAMP_IND | LAMP_HEAD, t_us);
+    } else if (r->can_id == ENGINE_CAN_ID) {
+        dashboard_notice("Engine command rejected: %s", e2e_strerror(r->err));
+        atomic_store(&engine_reported, r->state ? 1 : 0);
+    }
+}
+
+// Whole burst against one database version, published to the vehicle state once
+int dashboard_sensor_rx(int flags) {
+    static uint32_t generation = 0;
+    struct can_frame frame;
+    uint64_t rx_us;
+    int token;
+
+    int got = can_recv(&frame, &rx_us, flags);
+    if (got < 0)
+        return -1;
+
+    const struct signal_db *db = signal_db_acquire(&token);
+    if (db->generation != generation) {
+        apply_deadbands(db);
+        apply_filters(db);
+        deadlines_configure(db);
+        generation = db->generation;
+    }
+
+    int burst = 0, alarms = 0, fresh = 0, reports = 0;
+    struct e2e_report report[RX_BURST_MAX];
+    signal_history_begin(&sensor_history);
+    alarm_begin(&dash_alarms);
+    deadline_begin(&sensor_deadlines);
+    // Monitor indexes belong to one database version; a reload racing this burst skips it
+    struct deadline_monitor *mon = (sensor_deadlines.generation == db->generation) ? &sensor_deadlines : NULL;
+    do {
+        if (got > 0 && frame.can_id == E2E_REPORT_CAN_ID)
+            reports += e2e_report_decode(frame.data, frame.can_dlc, &report[reports]) == 0;
+        else if (got > 0)
+            alarms |= sensor_decode(db, &frame, rx_us, mon, &fresh);
+    } while (++burst < RX_BURST_MAX && (got = can_recv(&frame, &rx_us, MSG_DONTWAIT)) >= 0);
+    rx_bursts++;
+    deadline_end(&sensor_deadlines);
+    alarm_end(&dash_alarms);
+    signal_history_end(&sensor_history);
+    signal_db_release(token);
+    alarms_publish(alarms);
+    sensor_filter_step();
+    for (int i = 0; i < reports; i++)
+        command_rejected(&report[i], rx_us);
+
+    struct vehicle_state *vs = vehicle_state_write_begin(vehicle);
+    int changed = signal_watch_flush(&sensor_watch);
+    if (fresh)
+        stale_apply(vs);
+    vehicle_state_write_end(vehicle);
+
+    if (changed > 0 || fresh)
+        request_redraw();
+    return changed;
+}
+
+// ============ Signal Database ============
+// Receive filter: every message in the database plus the command and report ids. A database with
+// more messages than filters gets everything; the id lookup drops the rest.
+static void apply_can_filter(const struct signal_db *db) {
+    struct can_filter filter[MAX_CAN_FILTERS];
+    int n = 0;
+
+    filter[n++] = (struct can_filter){.can_id = BCM_CAN_ID,    .can_mask = CAN_SFF_MASK};
+    filter[n++] = (struct can_filter){.can_id = ENGINE_CAN_ID, .can_mask = CAN_SFF_MASK};
+    filter[n++] = (struct can_filter){.can_id = E2E_REPORT_CAN_ID, .can_mask = CAN_SFF_MASK};
+    if (db->n_messages > (uint32_t)(MAX_CAN_FILTERS - n)) {
+        dashboard_notice("%u messages exceed %d CAN filters, receiving all frames",
+                         db->n_messages, MAX_CAN_FILTERS - n);
+        filter[0] = (struct can_filter){.can_id = 0, .can_mask = 0};
+        n = 1;
+    } else {
+        for (uint32_t i = 0; i < db->n_messages; i++)
+            filter[n++] = (struct can_filter){.can_id = db->messages[i].can_id, .can_mask = CAN_SFF_MASK};
+    }
+
+    if (setsockopt(can_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filter, n * sizeof(struct can_filter)) < 0)
+        perror("CAN filter failed");
+}
+
+void dashboard_db_changed(void) {
+    int token;
+
+    if (!signal_db_watch_changed(db_watch_fd))
+        return;
+    if (signal_db_reload() < 0)
+        return;  // keep running with the previous version
+
+    const struct signal_db *db = signal_db_acquire(&token);
+    apply_can_filter(db);
+    deadlines_configure(db);
+    signal_db_release(token);
+    alarms_load();  // thresholds are in raw units of the new version
+    request_redraw();
+}
+
+// ============ Command Transmit ============
+// Secures the frame (SecOC if keyed and authenticated, else E2E profile), then writes it
+int send_command(struct can_frame *frame, struct e2e_tx_state *tx, struct secoc_tx_state *sec_tx) {
+    const struct e2e_profile *profile = e2e_profile_lookup(frame->can_id);
+    int dlc = frame->can_dlc;
+
+    if (secoc_enabled && sec_tx != NULL && secoc_authenticated(frame->can_id))
+        dlc = secoc_protect(&secoc_key, sec_tx, frame->can_id, frame->data, frame->can_dlc);
+    else if (profile != NULL)
+        dlc = e2e_protect(profile, tx, frame->data);
+
+    if (dlc < 0) {
+        fprintf(stderr, "Payload too long to secure 0x%03X\n", frame->can_id);
+        return -1;
+    }
+    frame->can_dlc = dlc;
+
+    return write(can_socket, frame, sizeof(struct can_frame));
+}
+
+// A restarted dashboard counts from 0 again: the sync frame hands the node the new
+// counter, or the first command would be rejected. Not for ids SecOC secures.
+static void send_sync(uint32_t can_id, struct e2e_tx_state *tx, struct secoc_tx_state *sec_tx) {
+    struct can_frame frame = {.can_id = can_id};
+
+    if (secoc_enabled && sec_tx != NULL && secoc_authenticated(can_id))
+        return;
+    int dlc = e2e_sync(e2e_profile_lookup(can_id), tx, frame.data);
+    if (dlc < 0)
+        return;
+    frame.can_dlc = dlc;
+    if (write(can_socket, &frame, sizeof(frame)) != sizeof(frame))
+        perror("E2E sync write failed");
+}
+
+// Key file: 32 hex digits (AES-128)
+static int load_secoc_key(const char *path) {
+    uint8_t raw[SECOC_KEY_LEN];
+    char hex[2 * SECOC_KEY_LEN + 1];
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL) {
+        perror("SecOC key open failed");
+        return -1;
+    }
+    int n = fscanf(fp, "%32s", hex);
+    fclose(fp);
+
+    if (n != 1 || strlen(hex) != 2 * SECOC_KEY_LEN || secoc_key_parse(hex, raw) < 0) {
+        fprintf(stderr, "%s: expected %d hex digits\n", path, 2 * SECOC_KEY_LEN);
+        return -1;
+    }
+
+    secoc_key_init(&secoc_key, raw);
+    memset(raw, 0, sizeof(raw));
+    engine_sec_tx.freshness = secoc_boot_freshness();
+
+    // Accepted response freshness lives beside the key, so recorded responses
+    // cannot be replayed into a restarted dashboard
+    secoc_persist_init(path);
+    secoc_rx_restore(&door_sec_rx, "door_rx");
+    secoc_rx_restore(&seatbelt_sec_rx, "seatbelt_rx");
+    secoc_enabled = 1;
+    return 0;
+}
+
+// ============ Engine ============
+static const uint32_t check_ids[CHECK_COUNT] = {
+    [CHECK_DOOR]     = DOOR_CAN_ID,
+    [CHECK_SEATBELT] = SEATBELT_CAN_ID,
+};
+
+// Nodes another requester asked that have not answered since; same owner as status_cache
+static uint32_t foreign_asked;
+
+static int check_index(uint32_t id) {
+    for (int i = 0; i < CHECK_COUNT; i++)
+        if (check_ids[i] == id)
+            return i;
+    return -1;
+}
+
+int dashboard_status_recv(struct engine_checks *c, int flags) {
+    struct can_frame frame;
+    char control[CMSG_SPACE(sizeof(struct timeval))];
+    struct iovec iov = {.iov_base = &frame, .iov_len = sizeof(frame)};
+    struct msghdr msg = {
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control, .msg_controllen = sizeof(control),
+    };
+
+    if (recvmsg(rtr_socket, &msg, flags) != sizeof(frame))
+        return -1;
+
+    uint32_t id = frame.can_id & CAN_SFF_MASK;
+    int check = check_index(id);
+    if (check < 0)
+        return 0;
+    // Someone else's request: the node's next reply may answer it rather than ours
+    if (frame.can_id & CAN_RTR_FLAG) {
+        foreign_asked |= 1u << check;
+        if (c != NULL)
+            rtr_shared(&c->req, id);
+        return 0;
+    }
+    foreign_asked &= ~(1u << check);
+    uint64_t rx_us = rx_time_us(&msg);
+
+    // Rejected frames still answer the request (as not closed / not fastened), but are never cached
+    int status = 0;
+    int valid = 1;
+    if (secoc_enabled && secoc_authenticated(id)) {
+        struct secoc_rx_state *rx = (id == DOOR_CAN_ID) ? &door_sec_rx : &seatbelt_sec_rx;
+        int len = secoc_verify(&secoc_key, rx, id, frame.data, frame.can_dlc);
+        if (len < 1) {
+            dashboard_notice("Rejected response from 0x%03X: %s", id, secoc_strerror(len));
+            valid = 0;
+        } else if (secoc_rx_persist(rx, (id == DOOR_CAN_ID) ? "door_rx" : "seatbelt_rx") < 0) {
+            dashboard_notice("Rejected response from 0x%03X: freshness not stored", id);
+            valid = 0;
+        }
+    }
+    if (valid) {
+        status = (frame.data[0] == 1) ? 1 : 0;
+        rtr_cache_put(&status_cache, id, status, rx_us);
+        alarm_input((id == DOOR_CAN_ID) ? ALARM_IN_DOOR : ALARM_IN_SEATBELT, status, rx_us);
+    }
+
+    if (c != NULL && rtr_match(&c->req, &frame, rx_us) >= 0)
+        c->status[check] = status;
+    return 0;
+}
+
+// Stale statuses are requested back to back; the RTR DLC announces the expected (secured) length
+static void checks_begin(struct engine_checks *c) {
+    uint32_t ids[CHECK_COUNT];
+    int n = 0;
+
+    // Whatever arrived since the last batch (late answers, replies to other requesters)
+    while (dashboard_status_recv(NULL, MSG_DONTWAIT) == 0)
+        ;
+
+    uint64_t now = monotonic_us();
+    for (int i = 0; i < CHECK_COUNT; i++) {
+        if (!rtr_cache_get(&status_cache, check_ids[i], now, &c->status[i])) {
+            c->status[i] = 0;
+            ids[n++] = check_ids[i];
+        }
+    }
+    rtr_send(&c->req, rtr_socket, ids, n, secoc_enabled ? 1 + SECOC_OVERHEAD : 1, now, &rtr_timing);
+    for (int i = 0; i < CHECK_COUNT; i++)
+        if (foreign_asked & (1u << i))
+            rtr_shared(&c->req, check_ids[i]);
+}
+
+// Door and seat belt go to the display; returns 1 if the engine may start
+static int checks_passed(struct engine_checks *c) {
+    int door = c->status[CHECK_DOOR], belt = c->status[CHECK_SEATBELT];
+    struct vehicle_state *vs = vehicle_state_write_begin(vehicle);
+    vs->door     = door;
+    vs->seatbelt = belt;
+    vehicle_state_write_end(vehicle);
+    request_redraw();
+
+    // Silent nodes (no reply after the retry) are named in one notice; they count as open / not fastened
+    if (c->req.failed) {
+        char nodes[8 * CHECK_COUNT + 1] = "";
+        size_t len = 0;
+        for (int i = 0; i < c->req.n; i++)
+            if (c->req.failed & (1u << i))
+                len += snprintf(nodes + len, sizeof(nodes) - len, " 0x%03X", c->req.ids[i]);
+        dashboard_notice("Timeout: No response from node%s", nodes);
+        return 0;
+    }
+
+    if ((door != 1) || (belt != 1)) {
+        dashboard_notice("Error: Check Door and Seat Belt before starting engine");
+        return 0;
+    }
+    return 1;
+}
+
+static void engine_send(uint8_t command) {
+    struct can_frame frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id  = ENGINE_CAN_ID;
+    frame.can_dlc = 1;
+    frame.data[0] = command;
+
+    uint64_t t = monotonic_us();
+    send_command(&frame, &engine_tx, &engine_sec_tx);
+    latency_write(&cmd_latency, (command == EN_ON) ? OPTION_ENGINE_START : OPTION_ENGINE_STOP, &frame, t);
+}
+
+// ============ Engine State Machine ============
+struct engine_fsm engine;
+
+static const char *const engine_state_names[] = {
+    [ENG_IDLE]     = "idle",
+    [ENG_CHECKING] = "checking",
+    [ENG_STARTING] = "starting",
+    [ENG_RUNNING]  = "running",
+    [ENG_STOPPING] = "stopping",
+};
+
+const char *engine_state_name(int state) {
+    return engine_state_names[state];
+}
+
+static void engine_enter(int state, uint64_t now_us) {
+    struct engine_transition *t = &engine.log[engine.transitions++ % ENGINE_LOG_LEN];
+
+    t->from  = engine.state;
+    t->to    = state;
+    t->at_us = now_us;
+
+    engine.state = state;
+    engine.entered_us = now_us;
+
+    vehicle_state_write_begin(vehicle)->engine = state;
+    vehicle_state_write_end(vehicle);
+    request_redraw();
+    alarm_input(ALARM_IN_ENGINE, state, now_us);
+}
+
+void dashboard_engine_request(int start, uint64_t now_us) {
+    if (!start) {
+        // Nothing was sent yet while checking; anywhere else the engine is told at once
+        if (engine.state == ENG_CHECKING) {
+            dashboard_notice("Engine start cancelled");
+            engine_enter(ENG_IDLE, now_us);
+            return;
+        }
+        engine_send(EN_OFF);
+        engine.timer_us = now_us + ENGINE_SPINDOWN_MS * 1000;
+        engine_enter(ENG_STOPPING, now_us);
+        return;
+    }
+
+    if (engine.state != ENG_IDLE && engine.state != ENG_STOPPING) {
+        dashboard_notice("Engine already %s", engine_state_name(engine.state));
+        return;
+    }
+
+    checks_begin(&engine.checks);
+    engine_enter(ENG_CHECKING, now_us);
+    dashboard_engine_tick(now_us);  // the status cache may have answered already
+}
+
+void dashboard_engine_rtr(uint64_t now_us) {
+    while (dashboard_status_recv((engine.state == ENG_CHECKING) ? &engine.checks : NULL, MSG_DONTWAIT) == 0)
+        ;
+    dashboard_engine_tick(now_us);
+}
+
+void dashboard_engine_tick(uint64_t now_us) {
+    // The engine node refused a command: follow what it reports instead of the timers
+    int reported = atomic_exchange(&engine_reported, -1);
+    if (reported == 0 && (engine.state == ENG_STARTING || engine.state == ENG_RUNNING))
+        engine_enter(ENG_IDLE, now_us);
+    else if (reported == 1 && (engine.state == ENG_STOPPING || engine.state == ENG_IDLE))
+        engine_enter(ENG_RUNNING, now_us);
+
+    switch (engine.state) {
+    case ENG_CHECKING:
+        rtr_expire(&engine.checks.req, now_us);    // retries go out from here
+        if (!rtr_complete(&engine.checks.req))
+            break;
+        if (!checks_passed(&engine.checks)) {
+            engine_enter(ENG_IDLE, now_us);
+            break;
+        }
+        engine_send(EN_ON);
+        engine.timer_us = now_us + ENGINE_CRANK_MS * 1000;
+        engine_enter(ENG_STARTING, now_us);
+        break;
+    case ENG_STARTING:
+        if (now_us >= engine.timer_us)
+            engine_enter(ENG_RUNNING, now_us);
+        break;
+    case ENG_STOPPING:
+        if (now_us >= engine.timer_us)
+            engine_enter(ENG_IDLE, now_us);
+        break;
+    }
+}
+
+uint64_t dashboard_engine_deadline(void) {
+    switch (engine.state) {
+    case ENG_CHECKING:
+        return rtr_next_deadline(&engine.checks.req);
+    case ENG_STARTING:
+    case ENG_STOPPING:
+        return engine.timer_us;
+    }
+    return UINT64_MAX;
+}
+
+// ============ Process User Option ============
+// Lamp states and change mask sent to the BCM for each menu option
+static const struct {
+    uint8_t lamps;
+    uint8_t mask;
+} bcm_options[10] = {
+    [1] = {LAMP_LEFT,            LAMP_IND},
+    [2] = {LAMP_RIGHT,           LAMP_IND},
+    [3] = {LAMP_IND,             LAMP_IND},
+    [4] = {0,                    LAMP_IND},
+    [5] = {LAMP_HEAD,            LAMP_HEAD},
+    [6] = {0,                    LAMP_HEAD},
+    [9] = {LAMP_IND | LAMP_HEAD, LAMP_IND | LAMP_HEAD},
+};
+
+int dashboard_option(int option) {
+    struct can_frame frame;
+
+    latency_dispatch(&cmd_latency, option, monotonic_us());
+
+    // A new command supersedes the previous notice
+    vehicle_state_write_begin(vehicle)->notice[0] = '\0';
+    vehicle_state_write_end(vehicle);
+    request_redraw();
+
+    // BCM commands (options 1-6, 9): one command word per option
+    if (!((option >= 1 && option <= 6) || option == 9))
+        return 0;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id  = BCM_CAN_ID;
+    frame.can_dlc = 3;
+    frame.data[0] = BCM_CMD_WORD;
+    frame.data[1] = bcm_options[option].lamps;
+    frame.data[2] = bcm_options[option].mask;
+
+    uint64_t t = monotonic_us();
+    send_command(&frame, &bcm_tx, NULL);
+    latency_write(&cmd_latency, option, &frame, t);
+
+    // Taken as done; a rejection report from the BCM puts back its own lamps
+    lamps_publish(bcm_options[option].lamps, bcm_options[option].mask, t);
+    return 1;
+}
+
+// ============ Setup / Teardown ============
+// Sensors, alarms and sockets, publishing into the vehicle state
+static int setup_io(void) {
+    struct can_filter rtr_filter[2] = {
+        {.can_id = DOOR_CAN_ID,     .can_mask = CAN_SFF_MASK},
+        {.can_id = SEATBELT_CAN_ID, .can_mask = CAN_SFF_MASK},
+    };
+    int token;
+
+    if (signal_watch_init(&sensor_watch, slot_count, sensor_changed, &vehicle->state) < 0) return -1;
+    if (signal_history_init(&sensor_history, slot_count) < 0) return -1;
+    if (filter_bank_init(&sensor_filter, filter_current, slot_count) < 0) return -1;
+
+    // Every monitored message is due one timeout from now, received yet or not
+    deadline_init(&sensor_deadlines);
+    deadlines_configure(signal_db_acquire(&token));
+    signal_db_release(token);
+
+    // Lamps and engine start out known (off, idle); door and seat belt once a node answers
+    if (alarm_init(&dash_alarms, slot_count) < 0) return -1;
+    if (alarms_load() < 0) return -1;
+    uint64_t now = monotonic_us();
+    for (int input = ALARM_IN_LEFT_IND; input <= ALARM_IN_ENGINE; input++)
+        alarm_input(input, 0, now);
+
+    can_socket = initialize_can_socket(CAN_INF, NULL, 0);
+    if (can_socket < 0) return -1;
+
+    // Before own frames come back, so the latency traces never see the sync frames
+    send_sync(ENGINE_CAN_ID, &engine_tx, &engine_sec_tx);
+    send_sync(BCM_CAN_ID, &bcm_tx, NULL);
+
+    // Own frames come back once sent: the TX confirmation for command latency
+    int one = 1;
+    latency_init(&cmd_latency, option_names);
+    setsockopt(can_socket, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &one, sizeof(one));
+    setsockopt(can_socket, SOL_SOCKET, SO_TIMESTAMP, &one, sizeof(one));
+    apply_can_filter(signal_db_acquire(&token));
+    signal_db_release(token);
+
+    rtr_socket = initialize_can_socket(CAN_INF, rtr_filter, sizeof(rtr_filter));
+    if (rtr_socket < 0) return -1;
+    setsockopt(rtr_socket, SOL_SOCKET, SO_TIMESTAMP, &one, sizeof(one));
+    rtr_cache_init(&status_cache, lease_ms);
+    rtr_timing_init(&rtr_timing, rtr_floor_ms, rtr_ceiling_ms);
+
+    db_watch_fd = signal_db_watch();
+    return 0;
+}
+
+// Per-slot buffers, sized once the first database has fixed the slots
+static int slots_alloc(void) {
+    int token;
+
+    slot_count = signal_db_acquire(&token)->n_slots;
+    signal_db_release(token);
+    slot_words = (slot_count + 63) / 64;
+    slots_written  = calloc(slot_words, sizeof(*slots_written));
+    slots_taken    = calloc(slot_words, sizeof(*slots_taken));
+    stale_shown    = calloc(slot_words, sizeof(*stale_shown));
+    stale_now      = calloc(slot_words, sizeof(*stale_now));
+    filter_waiting = calloc(slot_count, sizeof(*filter_waiting));
+    filter_current = calloc(slot_count, sizeof(*filter_current));
+    snapshot = vehicle_state_alloc(slot_count);
+    if (slots_written == NULL || slots_taken == NULL || stale_shown == NULL || stale_now == NULL ||
+        filter_waiting == NULL || filter_current == NULL || snapshot == NULL) {
+        perror("slot buffers");
+        return -1;
+    }
+    return 0;
+}
+
+static void slots_free(void) {
+    free(slots_written);
+    free(slots_taken);
+    free(stale_shown);
+    free(stale_now);
+    free(filter_waiting);
+    free(filter_current);
+    free(snapshot);
+}
+
+int dashboard_setup(int argc, char *argv[]) {
+    const char *db_path = NULL;
+    int opt;
+
+    // -d <file>: signal database (text or signal_dbc binary), reloaded on change
+    // -k <file>: SecOC key, authenticates engine commands and door/seat belt responses
+    // -f <fps>:  maximum redraw rate
+    // -l <ms>:   door / seat belt status lease, 0 polls on every engine start
+    // -t <floor>,<ceiling>: RTR wait bounds in ms (per attempt / per node overall)
+    // -s <path>: state socket (daemon)
+    // -m <name>: shared memory state page
+    // -a <file>: alarm rules, recompiled whenever the database is reloaded
+    while ((opt = getopt(argc, argv, "d:k:f:l:t:s:m:a:")) != -1) {
+        if (opt == 'd')
+            db_path = optarg;
+        else if (opt == 'k') {
+            if (load_secoc_key(optarg) < 0) return -1;
+        } else if (opt == 'f' && atoi(optarg) > 0)
+            max_fps = atoi(optarg);
+        else if (opt == 'l' && atoi(optarg) >= 0)
+            lease_ms = atoi(optarg);
+        else if (opt == 't' && sscanf(optarg, "%u,%u", &rtr_floor_ms, &rtr_ceiling_ms) == 2 &&
+                 rtr_floor_ms > 0 && rtr_floor_ms <= rtr_ceiling_ms)
+            ;
+        else if (opt == 's')
+            state_socket_path = optarg;
+        else if (opt == 'm')
+            state_page_name = optarg;
+        else if (opt == 'a')
+            alarm_path = optarg;
+        else {
+            fprintf(stderr, "Usage: %s [-d signal_db] [-k secoc_key] [-f max_fps] [-l lease_ms] [-t floor_ms,ceiling_ms] [-s state_socket] [-m state_page] [-a alarm_rules]\n",
+                    argv[0]);
+            return -1;
+        }
+    }
+
+    if (screen_init(&dash_screen, DASH_ROWS, DASH_COLS) < 0) return -1;
+    const struct layout_source source = {
+        slot_value, &dash_alarms, &sensor_history, TREND_POINTS, TREND_SPAN_S, TREND_WINDOW_S,
+        engine_state_names, ENG_STOPPING + 1,
+    };
+    if (layout_init(&dash_layout, dash_widgets, sizeof(dash_widgets) / sizeof(dash_widgets[0]), &source) < 0) return -1;
+    e2e_init();
+    if (signal_db_init(db_path) < 0) return -1;
+    if (slots_alloc() < 0) return -1;
+
+    // Published straight into the shared page: local readers cost the receive path nothing
+    state_page = vehicle_state_page_create(state_page_name, slot_count);
+    if (state_page != NULL)
+        vehicle = &state_page->pub;
+    else {
+        fprintf(stderr, "Vehicle state not shared (%s)\n", state_page_name);
+        private_state = malloc(vehicle_state_pub_size(slot_count));
+        if (private_state == NULL) {
+            perror("vehicle state");
+            return -1;
+        }
+        vehicle = private_state;
+        vehicle_state_init(vehicle, slot_count);
+    }
+    if (setup_io() < 0) {
+        // Nothing was published: do not leave the page behind
+        if (state_page != NULL)
+            vehicle_state_page_destroy(state_page, state_page_name);
+        state_page = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Context switches and CPU time for the whole process, to compare execution models
+void dashboard_teardown(const char *mode) {
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    printf("\nDashboard shutdown complete (%s).\n", mode);
+    printf("  frames: %llu, %llu bytes to the terminal, %.1f of %u widgets redrawn per frame\n",
+           (unsigned long long)dash_screen.frames, (unsigned long long)dash_screen.bytes,
+           dash_layout.frames ? (double)dash_layout.redrawn / dash_layout.frames : 0.0, dash_layout.n);
+    printf("  sensors: %llu samples in %llu bursts, %.1f per frame\n",
+           (unsigned long long)rx_samples, (unsigned long long)rx_bursts,
+           dash_screen.frames ? (double)rx_samples / dash_screen.frames : 0.0);
+    printf("  status cache: %llu hits, %llu polled (lease %u ms)\n",
+           (unsigned long long)status_cache.hits, (unsigned long long)status_cache.misses, lease_ms);
+    printf("  rtr: %llu retries, %llu failures\n",
+           (unsigned long long)rtr_timing.retries, (unsigned long long)rtr_timing.failures);
+    for (int i = 0; i < CHECK_COUNT; i++) {
+        uint64_t p99 = rtr_rtt_percentile(&rtr_timing, check_ids[i], RTR_RTT_PERCENTILE);
+        printf("    0x%03X: ", check_ids[i]);
+        if (p99)
+            printf("p50 < %llu us, p99 < %llu us, ",
+                   (unsigned long long)rtr_rtt_percentile(&rtr_timing, check_ids[i], 50), (unsigned long long)p99);
+        else
+            printf("too few samples, ");
+        printf("timeout %llu us\n", (unsigned long long)rtr_attempt_timeout_us(&rtr_timing, check_ids[i]));
+    }
+    printf("  engine: %s, %u transitions\n", engine_state_name(engine.state), engine.transitions);
+    uint32_t first = (engine.transitions > ENGINE_LOG_LEN) ? engine.transitions - ENGINE_LOG_LEN : 0;
+    for (uint32_t i = first; i < engine.transitions; i++) {
+        const struct engine_transition *t = &engine.log[i % ENGINE_LOG_LEN];
+        const struct engine_transition *prev = (i > first) ? &engine.log[(i - 1) % ENGINE_LOG_LEN] : NULL;
+        printf("    %-8s -> %-8s after %.1f ms\n", engine_state_name(t->from), engine_state_name(t->to),
+               prev ? (t->at_us - prev->at_us) / 1000.0 : 0.0);
+    }
+    printf("  context switches: %ld voluntary, %ld involuntary\n", ru.ru_nvcsw, ru.ru_nivcsw);
+    printf("  cpu: %ld.%06ld s user, %ld.%06ld s system\n",
+           (long)ru.ru_utime.tv_sec, (long)ru.ru_utime.tv_usec,
+           (long)ru.ru_stime.tv_sec, (long)ru.ru_stime.tv_usec);
+
+    latency_report(&cmd_latency, stdout);
+
+    printf("  filters: %llu steps (%s)\n", (unsigned long long)sensor_filter.steps, filter_impl());
+    printf("  deadlines: %u monitored, %llu expired, %llu recovered, %u stale now\n", sensor_deadlines.n,
+           (unsigned long long)sensor_deadlines.expired, (unsigned long long)sensor_deadlines.recovered,
+           sensor_deadlines.n_stale);
+    printf("  alarms: %d rules, %llu raised, %d active\n", dash_alarms.n_rules,
+           (unsigned long long)dash_alarms.raised, __builtin_popcount(dash_alarms.active));
+    if (dash_alarms.raise_hist.total)
+        printf("    input to raise p50 < %llu us, p99 < %llu us, max %llu us; to screen p50 < %llu us, p99 < %llu us, max %llu us\n",
+               (unsigned long long)hist_percentile(&dash_alarms.raise_hist, 50),
+               (unsigned long long)hist_percentile(&dash_alarms.raise_hist, 99),
+               (unsigned long long)hist_max(&dash_alarms.raise_hist),
+               (unsigned long long)hist_percentile(&dash_alarms.show_hist, 50),
+               (unsigned long long)hist_percentile(&dash_alarms.show_hist, 99),
+               (unsigned long long)hist_max(&dash_alarms.show_hist));
+
+    screen_free(&dash_screen);
+    layout_free(&dash_layout);
+    signal_history_free(&sensor_history);
+    filter_bank_free(&sensor_filter);
+    deadline_free(&sensor_deadlines);
+    alarm_free(&dash_alarms);
+    if (state_page != NULL)
+        vehicle_state_page_destroy(state_page, state_page_name);
+    free(private_state);
+    slots_free();
+    if (db_watch_fd >= 0)
+        close(db_watch_fd);
+    close(can_socket);
+    close(rtr_socket);
+    signal_db_shutdown();
+}
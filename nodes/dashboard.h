@@ -0,0 +1,189 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include "signal_db.h"
+#include "signal_watch.h"
+#include "signal_history.h"
+#include "signal_filter.h"
+#include "alarm.h"
+#include "deadline.h"
+#include "e2e.h"
+#include "secoc.h"
+#include "screen.h"
+#include "widget.h"
+#include "vehicle_state.h"
+#include "rtr.h"
+#include "latency.h"
+
+/*
+ * Dashboard core, shared by the three execution models:
+ *
+ *   dashboard_thread   - input, sensor, engine and DB watch threads
+ *   dashboard_reactor  - one epoll loop, engine start as non-blocking steps
+ *   dashboard_daemon   - the reactor without a terminal, state served on a Unix socket
+ *
+ * The core never blocks and never creates threads. Each model provides
+ * request_redraw() to schedule a frame (or a state publish) its own way.
+ */
+
+// Screen layout
+#define DASH_ROWS       24
+#define DASH_COLS       80
+#define PROMPT_ROW      23
+#define PROMPT_TEXT     "Enter option: "
+
+// Trend sparklines right of the coolant and tyre lines, from sensor_history
+#define TREND_COL       50
+#define TREND_POINTS    16
+#define TREND_SPAN_S    120     // sparkline covers the last 2 minutes
+#define TREND_WINDOW_S  300     // extreme shown next to it, last 5 minutes
+
+#define RX_BURST_MAX      64    // frames drained per receive burst
+#define MAX_CAN_FILTERS   256
+#define DEFAULT_MAX_FPS   30    // redraws per second at most, bursts are coalesced
+#define RTR_TIMEOUT_MS    1000  // ceiling: longest wait for a node, retry included
+#define RTR_FLOOR_MS      5     // shortest wait per attempt, however fast the node
+#define DEFAULT_LEASE_MS  200   // door / seat belt status younger than this is not re-polled
+
+// Menu options handled by the execution model rather than the core
+#define OPTION_EXIT          0
+#define OPTION_ENGINE_START  7
+#define OPTION_ENGINE_STOP   8
+
+/* ============ Shared State ============ */
+extern int can_socket, rtr_socket;
+extern int db_watch_fd;             // -1 if the database file is not watched
+extern int max_fps;
+extern const char *state_socket_path;   // dashboard_daemon only
+
+// Flags, sensor values (raw signal units, one per slot of the signal database) and the
+// notice line, seqlock-published in the shared memory page state_page_name (other
+// processes map it read-only)
+extern struct vehicle_state_pub *vehicle;
+extern const char *state_page_name;
+extern struct signal_watch sensor_watch;
+extern struct signal_history sensor_history;   // every received value, per slot
+// Smoothing per slot (the database's filter=), every received sample is filtered; the
+// watch publishes the filtered values, history and alarms keep the raw ones
+extern struct filter_bank sensor_filter;
+
+// Alarm rules (-a file, else alarm_default_text), recompiled with the database;
+// the active set is published in vehicle->alarms
+extern struct alarm_set dash_alarms;
+extern const char *alarm_path;
+
+// Reception deadlines of the database's monitored messages and pages; the slots
+// they carry are flagged stale in vehicle's sensor entries while they are overdue
+extern struct deadline_monitor sensor_deadlines;
+
+// E2E alive counters, one per protected command stream (each has a single writer)
+extern struct e2e_tx_state engine_tx, bcm_tx;
+
+// SecOC, enabled by -k: authenticated IDs carry freshness + truncated CMAC instead of E2E
+extern int secoc_enabled;
+extern struct secoc_key secoc_key;
+extern struct secoc_tx_state engine_sec_tx;
+
+// Screen model and the widget layout on it, drawn and flushed by the rendering context only
+extern struct screen dash_screen;
+extern struct layout dash_layout;
+
+// Keypress-to-wire latency per menu option; models stamp the input, the core the rest
+extern struct latency cmd_latency;
+
+/* ============ Provided by the execution model ============ */
+void request_redraw(void);
+
+/* ============ Core ============ */
+// Options, database, sockets, screen; returns -1 after printing the reason
+int  dashboard_setup(int argc, char *argv[]);
+void dashboard_teardown(const char *mode);
+
+void dashboard_redraw(void);
+// Takes the slots written since the last call, then a consistent copy of the state;
+// both stay valid until the next call. For the one context that renders or publishes
+const struct vehicle_state *dashboard_snapshot(const uint64_t **changed);
+void dashboard_notice(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Reads a frame from can_socket (recv flags) and drains up to RX_BURST_MAX queued ones;
+// returns published changes, -1 if nothing was read. Command confirmations are taken here
+int  dashboard_sensor_rx(int flags);
+// The watched database file changed: reload, refilter, recompile the alarms, redraw
+void dashboard_db_changed(void);
+
+// Alarm debounce timers, driven by each model like the engine's
+uint64_t dashboard_alarm_deadline(void);    // UINT64_MAX if none is pending
+void     dashboard_alarm_tick(uint64_t now_us);
+
+// Message deadlines, likewise
+uint64_t dashboard_monitor_deadline(void);  // UINT64_MAX if nothing is monitored
+void     dashboard_monitor_tick(uint64_t now_us);
+
+int  send_command(struct can_frame *frame, struct e2e_tx_state *tx, struct secoc_tx_state *sec_tx);
+
+uint64_t monotonic_us(void);
+
+// Engine start checks: door and seat belt polled together, replies taken in any order
+#define CHECK_DOOR      0
+#define CHECK_SEATBELT  1
+#define CHECK_COUNT     2
+
+struct engine_checks {
+    struct rtr_request req;
+    int status[CHECK_COUNT];    // 1 = closed / fastened; 0 if missing or rejected
+};
+
+// Reads one frame from rtr_socket (recv flags), verifies it and caches the status;
+// answers c if it is waiting for that node (c may be NULL). -1 if nothing was read
+int  dashboard_status_recv(struct engine_checks *c, int flags);
+
+/* ============ Engine State Machine ============ */
+/*
+ * idle -> checking -> starting -> running -> stopping -> idle
+ *
+ * Start and stop are accepted at any step. Stop sends EN_OFF at once
+ * (cancelling the checks if nothing was sent yet); start while stopping
+ * begins the checks again. Starting and stopping settle on timers, since
+ * the engine node does not acknowledge. Driven by a single context (the
+ * engine thread or the reactor loop), which calls dashboard_engine_tick()
+ * by dashboard_engine_deadline() and dashboard_engine_rtr() when
+ * rtr_socket is readable. Every transition is timestamped.
+ */
+#define ENG_IDLE      0
+#define ENG_CHECKING  1
+#define ENG_STARTING  2
+#define ENG_RUNNING   3
+#define ENG_STOPPING  4
+
+#define ENGINE_CRANK_MS     800     // starting -> running
+#define ENGINE_SPINDOWN_MS  500     // stopping -> idle
+#define ENGINE_LOG_LEN      32
+
+struct engine_transition {
+    uint8_t  from, to;
+    uint64_t at_us;
+};
+
+struct engine_fsm {
+    int      state;
+    uint64_t entered_us;
+    uint64_t timer_us;          // end of starting / stopping
+    struct engine_checks checks;
+    struct engine_transition log[ENGINE_LOG_LEN];
+    uint32_t transitions;
+};
+
+extern struct engine_fsm engine;
+
+void        dashboard_engine_request(int start, uint64_t now_us);
+void        dashboard_engine_rtr(uint64_t now_us);
+void        dashboard_engine_tick(uint64_t now_us);
+uint64_t    dashboard_engine_deadline(void);    // UINT64_MAX while no timer runs
+const char *engine_state_name(int state);
+
+// Lamp options and notice handling; returns 0 if the option is not a BCM command
+int  dashboard_option(int option);
+
+#endif
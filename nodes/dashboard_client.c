@@ -0,0 +1,143 @@
+/*
+ * dashboard_client - State socket client for dashboard_daemon
+ * Prints the snapshot and every delta as the resulting state, one line
+ * each, and can inject menu options first.
+ *
+ *   dashboard_client                     (follow the state)
+ *   dashboard_client -c 5 -c 7 -n 10     (headlight on, start engine, 10 updates)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "state_proto.h"
+
+#define MAX_COMMANDS 16
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s socket] [-n updates] [-c option]...\n", prog);
+    fprintf(stderr, "  -s  state socket (default %s)\n", SS_DEFAULT_SOCKET);
+    fprintf(stderr, "  -n  exit after this many snapshots / deltas, 0 follows forever\n");
+    fprintf(stderr, "  -c  send a menu option (1-9), may be repeated\n");
+}
+
+static void print_state(const uint8_t *msg, uint32_t seq, int fields, const struct vehicle_state *vs) {
+    printf("%-8s seq %-6u %2d field%s  ind %d%d head %d engine %d door %d belt %d  sensors",
+           (msg[0] == SS_MSG_SNAPSHOT) ? "snapshot" : "delta", seq, fields, (fields == 1) ? " " : "s",
+           vs->left_ind, vs->right_ind, vs->headlight, vs->engine, vs->door, vs->seatbelt);
+    for (uint32_t slot = 0; slot < vs->n_slots; slot++)
+        printf(" %d", vs->sensor[slot].raw);
+    if (vs->alarms)
+        printf("  alarms 0x%x", vs->alarms);
+    const char *sep = "  stale ";
+    for (uint32_t slot = 0; slot < vs->n_slots; slot++) {
+        if (vs->sensor[slot].stale) {
+            printf("%s%u", sep, slot);
+            sep = ",";
+        }
+    }
+    if (vs->notice[0])
+        printf("  \"%s\"", vs->notice);
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    const char *path = SS_DEFAULT_SOCKET;
+    uint8_t commands[MAX_COMMANDS];
+    int n_commands = 0;
+    long updates = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:c:")) != -1) {
+        if (opt == 's')
+            path = optarg;
+        else if (opt == 'n')
+            updates = atol(optarg);
+        else if (opt == 'c' && n_commands < MAX_COMMANDS)
+            commands[n_commands++] = atoi(optarg);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("Connect failed - is dashboard_daemon running?");
+        return 1;
+    }
+
+    for (int i = 0; i < n_commands; i++) {
+        uint8_t msg[2] = {SS_MSG_COMMAND, commands[i]};
+        if (send(fd, msg, sizeof(msg), 0) < 0) {
+            perror("Send failed");
+            return 1;
+        }
+    }
+
+    // Sized by the daemon's snapshot: its slot count fixes the state and the largest message
+    struct vehicle_state *vs = NULL;
+    uint8_t *msg = NULL;
+    size_t msg_size = 0;
+
+    for (long seen = 0; updates == 0 || seen < updates;) {
+        uint32_t seq;
+        ssize_t len = recv(fd, NULL, 0, MSG_PEEK | MSG_TRUNC);
+
+        if (len > 0 && (size_t)len > msg_size) {
+            uint8_t *grown = realloc(msg, len);
+            if (grown == NULL) {
+                perror("Receive buffer");
+                break;
+            }
+            msg = grown;
+            msg_size = len;
+        }
+        if (len > 0)
+            len = recv(fd, msg, msg_size, 0);
+        if (len <= 0) {
+            if (len < 0)
+                perror("Receive failed");
+            break;
+        }
+
+        if (msg[0] == SS_MSG_ACK && len == 3) {
+            printf("ack      option %d %s\n", msg[1], (msg[2] == SS_ACK_OK) ? "accepted" : "rejected");
+            continue;
+        }
+
+        int slots = (msg[0] == SS_MSG_SNAPSHOT) ? state_slots(msg, len) : -1;
+        if (slots >= 0 && (vs == NULL || vs->n_slots != (uint32_t)slots)) {
+            free(vs);
+            vs = vehicle_state_alloc(slots);
+            if (vs == NULL) {
+                perror("Snapshot");
+                break;
+            }
+        }
+
+        int fields = vs ? state_decode(msg, len, vs, &seq) : -1;
+        if (fields < 0) {
+            fprintf(stderr, "Malformed message (type %d, %zd bytes)\n", msg[0], len);
+            continue;
+        }
+        print_state(msg, seq, fields, vs);
+        fflush(stdout);
+        seen++;
+    }
+
+    free(vs);
+    free(msg);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Headless Dashboard (daemon)
+ * The reactor without a terminal: one epoll loop over the sensor and RTR
+ * CAN sockets, the signal database watch, the state socket and signals
+ * (SIGUSR1 latency report, SIGINT/SIGTERM shutdown). Vehicle state goes
+ * to local clients (HMI, logger, test rigs) over a Unix socket as a
+ * snapshot plus deltas, published at most max_fps times per second.
+ * Clients inject menu options the same way the terminal would.
+ *
+ * Display, decoding and commands live in dashboard.c, shared with the other models.
+ */
+
+#include <linux/can.h>
+#include <errno.h>
+#include <stdio.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "can_header.h"
+#include "dashboard.h"
+#include "state_server.h"
+
+#define MAX_EVENTS  8
+
+/* ============ Loop State ============ */
+static int epoll_fd;
+static int signal_fd;
+static int running = 1;
+static int state_dirty = 1;
+
+static struct state_server server;
+
+// Single thread: the next loop iteration publishes it
+void request_redraw(void) {
+    state_dirty = 1;
+}
+
+static int watch_fd(int fd) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        return -1;
+    }
+    return 0;
+}
+
+// ============ Process Client Option ============
+// Clients may command the vehicle but not stop the daemon
+static int process_option(int option, uint64_t rx_us, void *ctx) {
+    (void)ctx;
+
+    if (option < 1 || option > 9)
+        return SS_ACK_REJECTED;
+    latency_input(&cmd_latency, option, rx_us);
+
+    // BCM commands (options 1-6, 9) and the notice line are handled by the core
+    if (dashboard_option(option))
+        return SS_ACK_OK;
+
+    // Engine commands (options 7-8)
+    dashboard_engine_request(option == OPTION_ENGINE_START, monotonic_us());
+    return SS_ACK_OK;
+}
+
+static void signal_readable(void) {
+    struct signalfd_siginfo info;
+
+    if (read(signal_fd, &info, sizeof(info)) != sizeof(info))
+        return;
+    if (info.ssi_signo == SIGUSR1)
+        latency_report(&cmd_latency, stderr);
+    else
+        running = 0;
+}
+
+// ============ MAIN ============
+int main(int argc, char *argv[]) {
+    struct epoll_event events[MAX_EVENTS];
+
+    // Blocked before anything else runs, so they only ever arrive through the signalfd
+    sigset_t signal_set;
+    sigemptyset(&signal_set);
+    sigaddset(&signal_set, SIGUSR1);
+    sigaddset(&signal_set, SIGINT);
+    sigaddset(&signal_set, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signal_set, NULL);
+
+    if (dashboard_setup(argc, argv) < 0) return 1;
+    if (state_server_init(&server, state_socket_path, vehicle->state.n_slots, process_option, NULL) < 0) return 1;
+
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        return 1;
+    }
+
+    signal_fd = signalfd(-1, &signal_set, SFD_NONBLOCK);
+    if (signal_fd < 0) {
+        perror("signalfd failed");
+        return 1;
+    }
+
+    if (watch_fd(can_socket) < 0 || watch_fd(rtr_socket) < 0 || watch_fd(signal_fd) < 0 ||
+        watch_fd(server.fd) < 0)
+        return 1;
+    if (db_watch_fd >= 0 && watch_fd(db_watch_fd) < 0)
+        return 1;
+
+    printf("Dashboard started (daemon) on %s. Publishes on change, up to %d per second.\n",
+           state_socket_path, max_fps);
+    fflush(stdout);
+
+    uint64_t next_publish_us = 0;
+    while (running) {
+        // Sleep until an fd is ready, the next publish is due or an engine, alarm or deadline timer expires
+        uint64_t now = monotonic_us();
+        uint64_t wake = UINT64_MAX;
+        if (state_dirty)
+            wake = (next_publish_us > now) ? next_publish_us : now;
+        if (dashboard_engine_deadline() < wake)
+            wake = dashboard_engine_deadline();
+        if (dashboard_alarm_deadline() < wake)
+            wake = dashboard_alarm_deadline();
+        if (dashboard_monitor_deadline() < wake)
+            wake = dashboard_monitor_deadline();
+        int timeout = (wake == UINT64_MAX) ? -1 : (wake > now) ? (int)((wake - now + 999) / 1000) : 0;
+
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == can_socket)
+                dashboard_sensor_rx(MSG_DONTWAIT);
+            else if (fd == rtr_socket)
+                dashboard_engine_rtr(monotonic_us());
+            else if (fd == db_watch_fd)
+                dashboard_db_changed();
+            else if (fd == server.fd)
+                state_server_process(&server, monotonic_us());
+            else if (fd == signal_fd)
+                signal_readable();
+        }
+
+        now = monotonic_us();
+        dashboard_engine_tick(now);
+        dashboard_alarm_tick(now);
+        dashboard_monitor_tick(now);
+
+        // Changes arriving within one period share a delta
+        if (running && state_dirty && now >= next_publish_us) {
+            const uint64_t *changed;
+
+            state_dirty = 0;
+            const struct vehicle_state *vs = dashboard_snapshot(&changed);
+            state_server_publish(&server, vs, changed);
+            alarm_shown(&dash_alarms, monotonic_us());
+            next_publish_us = now + 1000000 / max_fps;
+        }
+    }
+
+    close(signal_fd);
+    close(epoll_fd);
+    dashboard_teardown("daemon");
+    printf("  state socket: %llu published, %llu sent, %llu skipped, %llu commands, %d clients at exit\n",
+           (unsigned long long)server.published, (unsigned long long)server.sent,
+           (unsigned long long)server.skipped, (unsigned long long)server.commands, server.n_clients);
+    state_server_close(&server);
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Single-threaded Dashboard (reactor)
+ * One epoll loop over stdin, the sensor and RTR CAN sockets, the signal
+ * database watch and SIGUSR1 (command latency report, via signalfd).
+ * Nothing blocks: the engine state machine runs on its RTR replies and
+ * timers, and redraws are coalesced to max_fps through the epoll timeout.
+ *
+ * Display, decoding and commands live in dashboard.c, shared with dashboard_thread.
+ */
+
+#include <linux/can.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "can_header.h"
+#include "dashboard.h"
+
+#define MAX_EVENTS      8
+#define INPUT_LINE_MAX  64
+
+/* ============ Loop State ============ */
+static int epoll_fd;
+static int report_fd;
+static int running = 1;
+static int display_dirty = 1;
+
+static char input_line[INPUT_LINE_MAX];
+static size_t input_len;
+
+// Single thread: the next loop iteration picks it up
+void request_redraw(void) {
+    display_dirty = 1;
+}
+
+static int watch_fd(int fd) {
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        return -1;
+    }
+    return 0;
+}
+
+// ============ Process User Option ============
+static void process_option(int option) {
+    if (option == OPTION_EXIT) {
+        running = 0;
+        return;
+    }
+
+    // BCM commands (options 1-6, 9) and the notice line are handled by the core
+    if (dashboard_option(option))
+        return;
+
+    // Engine commands (options 7-8) take effect in this iteration, whatever step the engine is at
+    if ((option == OPTION_ENGINE_START) || (option == OPTION_ENGINE_STOP))
+        dashboard_engine_request(option == OPTION_ENGINE_START, monotonic_us());
+}
+
+// Non-blocking stdin, one option per line
+static void input_readable(void) {
+    char buf[INPUT_LINE_MAX];
+    ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+    uint64_t input_us = monotonic_us();
+
+    if (n <= 0) {
+        if (n == 0 || errno != EAGAIN)
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);  // end of input
+        return;
+    }
+
+    // The terminal echoed the typed line, so the screen no longer matches the model
+    screen_invalidate(&dash_screen);
+    request_redraw();
+
+    for (ssize_t i = 0; i < n && running; i++) {
+        if (buf[i] != '\n') {
+            if (input_len < sizeof(input_line) - 1)
+                input_line[input_len++] = buf[i];
+            continue;
+        }
+
+        char *end;
+        input_line[input_len] = '\0';
+        long option = strtol(input_line, &end, 10);
+        if (end != input_line) {
+            latency_input(&cmd_latency, (int)option, input_us);
+            process_option((int)option);
+        }
+        input_len = 0;
+    }
+}
+
+// SIGUSR1: command latency histograms to stderr, which shares the terminal
+static void report_readable(void) {
+    struct signalfd_siginfo info;
+
+    if (read(report_fd, &info, sizeof(info)) != sizeof(info))
+        return;
+    latency_report(&cmd_latency, stderr);
+    screen_invalidate(&dash_screen);
+    request_redraw();
+}
+
+// ============ MAIN ============
+int main(int argc, char *argv[]) {
+    struct epoll_event events[MAX_EVENTS];
+
+    // Blocked before anything else runs, so it only ever arrives through the signalfd
+    sigset_t report_set;
+    sigemptyset(&report_set);
+    sigaddset(&report_set, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &report_set, NULL);
+
+    if (dashboard_setup(argc, argv) < 0) return 1;
+
+    epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        return 1;
+    }
+
+    report_fd = signalfd(-1, &report_set, SFD_NONBLOCK);
+    if (report_fd < 0) {
+        perror("signalfd failed");
+        return 1;
+    }
+
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+    if (watch_fd(STDIN_FILENO) < 0 || watch_fd(can_socket) < 0 || watch_fd(rtr_socket) < 0 ||
+        watch_fd(report_fd) < 0)
+        return 1;
+    if (db_watch_fd >= 0 && watch_fd(db_watch_fd) < 0)
+        return 1;
+
+    printf("Dashboard started (reactor). Redraws on change, up to %d fps.\n", max_fps);
+
+    uint64_t next_frame_us = 0;
+    while (running) {
+        // Sleep until an fd is ready, the next frame is due or an engine, alarm or deadline timer expires
+        uint64_t now = monotonic_us();
+        uint64_t wake = UINT64_MAX;
+        if (display_dirty)
+            wake = (next_frame_us > now) ? next_frame_us : now;
+        if (dashboard_engine_deadline() < wake)
+            wake = dashboard_engine_deadline();
+        if (dashboard_alarm_deadline() < wake)
+            wake = dashboard_alarm_deadline();
+        if (dashboard_monitor_deadline() < wake)
+            wake = dashboard_monitor_deadline();
+        int timeout = (wake == UINT64_MAX) ? -1 : (wake > now) ? (int)((wake - now + 999) / 1000) : 0;
+
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+
+            if (fd == STDIN_FILENO)
+                input_readable();
+            else if (fd == can_socket)
+                dashboard_sensor_rx(MSG_DONTWAIT);
+            else if (fd == rtr_socket)
+                dashboard_engine_rtr(monotonic_us());
+            else if (fd == db_watch_fd)
+                dashboard_db_changed();
+            else if (fd == report_fd)
+                report_readable();
+        }
+
+        now = monotonic_us();
+        dashboard_engine_tick(now);
+        dashboard_alarm_tick(now);
+        dashboard_monitor_tick(now);
+
+        // Changes arriving within one frame period share a redraw
+        if (running && display_dirty && now >= next_frame_us) {
+            display_dirty = 0;
+            dashboard_redraw();
+            next_frame_us = monotonic_us() + 1000000 / max_fps;
+        }
+    }
+
+    close(report_fd);
+    close(epoll_fd);
+    dashboard_teardown("reactor");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <string.h>
+#include "deadline.h"
+
+// ============ Wheel ============
+static void slot_push(struct deadline_monitor *m, uint32_t index, uint64_t tick) {
+    uint32_t s = tick % DEADLINE_SLOTS;
+
+    m->entry[index].next = m->head[s];
+    m->head[s] = index;
+    m->occupied[s / 64] |= 1ull << (s % 64);
+}
+
+// Files an entry at the first tick at or after its deadline, never behind the wheel
+static void file(struct deadline_monitor *m, uint32_t index) {
+    const struct deadline_entry *e = &m->entry[index];
+    uint64_t due = (e->last_us + e->timeout_us + DEADLINE_TICK_US - 1) / DEADLINE_TICK_US;
+
+    slot_push(m, index, (due > m->tick) ? due : m->tick);
+}
+
+static void restale(struct deadline_monitor *m) {
+    memset(m->stale_bits, 0, m->stale_words * sizeof(*m->stale_bits));
+    m->n_stale = 0;
+    for (uint32_t i = 0; i < m->n; i++) {
+        const struct deadline_entry *e = &m->entry[i];
+        if (!e->stale)
+            continue;
+        for (uint32_t k = e->first_bit; k < e->first_bit + e->n_bits; k++)
+            m->stale_bits[m->bits[k] / 64] |= 1ull << (m->bits[k] % 64);
+        m->n_stale++;
+    }
+}
+
+// ============ Setup ============
+void deadline_init(struct deadline_monitor *m) {
+    memset(m, 0, sizeof(*m));
+    for (int s = 0; s < DEADLINE_SLOTS; s++)
+        m->head[s] = DEADLINE_NONE;
+    pthread_mutex_init(&m->lock, NULL);
+}
+
+void deadline_free(struct deadline_monitor *m) {
+    free(m->entry);
+    free(m->bits);
+    free(m->stale_bits);
+    m->entry = NULL;
+    m->bits = NULL;
+    m->stale_bits = NULL;
+    m->n = m->stale_words = 0;
+    pthread_mutex_destroy(&m->lock);
+}
+
+int deadline_configure(struct deadline_monitor *m, const struct deadline_spec *spec, uint32_t n,
+                       uint32_t n_bits, uint32_t generation, uint64_t now_us) {
+    uint32_t total = 0, words = (n_bits + 63) / 64;
+    for (uint32_t i = 0; i < n; i++)
+        total += spec[i].n;
+
+    struct deadline_entry *entry = calloc(n ? n : 1, sizeof(*entry));
+    uint32_t *bits = malloc((total ? total : 1) * sizeof(*bits));
+    uint64_t *stale_bits = calloc(words ? words : 1, sizeof(*stale_bits));
+    if (entry == NULL || bits == NULL || stale_bits == NULL) {
+        free(entry);
+        free(bits);
+        free(stale_bits);
+        return -1;
+    }
+
+    pthread_mutex_lock(&m->lock);
+    if (m->entry != NULL && generation <= m->generation) {
+        pthread_mutex_unlock(&m->lock);
+        free(entry);
+        free(bits);
+        free(stale_bits);
+        return 0;
+    }
+
+    free(m->entry);
+    free(m->bits);
+    free(m->stale_bits);
+    m->entry = entry;
+    m->bits = bits;
+    m->stale_bits = stale_bits;
+    m->stale_words = words;
+    m->n = n;
+    m->generation = generation;
+    for (int s = 0; s < DEADLINE_SLOTS; s++)
+        m->head[s] = DEADLINE_NONE;
+    memset(m->occupied, 0, sizeof(m->occupied));
+    m->tick = now_us / DEADLINE_TICK_US;
+
+    total = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        entry[i] = (struct deadline_entry){
+            .last_us = now_us, .timeout_us = spec[i].timeout_ms * 1000,
+            .id = spec[i].id, .first_bit = total,
+        };
+        for (uint32_t k = 0; k < spec[i].n; k++)
+            if (spec[i].bits[k] < n_bits)
+                bits[total++] = spec[i].bits[k];
+        entry[i].n_bits = total - entry[i].first_bit;
+        file(m, i);
+    }
+    restale(m);
+    pthread_mutex_unlock(&m->lock);
+    return 1;
+}
+
+// ============ Arrivals ============
+void deadline_begin(struct deadline_monitor *m) {
+    pthread_mutex_lock(&m->lock);
+}
+
+void deadline_end(struct deadline_monitor *m) {
+    pthread_mutex_unlock(&m->lock);
+}
+
+int deadline_kick(struct deadline_monitor *m, uint32_t index, uint64_t rx_us) {
+    if (index >= m->n)
+        return 0;
+    struct deadline_entry *e = &m->entry[index];
+
+    if (rx_us > e->last_us)
+        e->last_us = rx_us;
+    if (!e->stale)
+        return 0;
+
+    e->stale = 0;
+    file(m, index);
+    m->recovered++;
+    restale(m);
+    return 1;
+}
+
+// ============ Expiry ============
+int deadline_tick(struct deadline_monitor *m, uint64_t now_us,
+                  void (*fn)(const struct deadline_entry *e, void *ctx), void *ctx) {
+    uint64_t now_tick = now_us / DEADLINE_TICK_US;
+    int expired = 0;
+
+    pthread_mutex_lock(&m->lock);
+    // A late wakeup visits each slot once at most
+    uint64_t last = now_tick;
+    if (last >= m->tick + DEADLINE_SLOTS)
+        last = m->tick + DEADLINE_SLOTS - 1;
+
+    for (uint64_t t = m->tick; t <= last && t <= now_tick; t++) {
+        uint32_t s = t % DEADLINE_SLOTS;
+        uint32_t index = m->head[s];
+
+        m->head[s] = DEADLINE_NONE;
+        m->occupied[s / 64] &= ~(1ull << (s % 64));
+        m->tick = now_tick + 1;     // re-filed entries land ahead of this pass
+
+        while (index != DEADLINE_NONE) {
+            struct deadline_entry *e = &m->entry[index];
+            uint32_t next = e->next;
+
+            if (e->last_us + e->timeout_us > now_us)
+                file(m, index);
+            else {
+                e->stale = 1;
+                m->expired++;
+                expired++;
+                if (fn != NULL)
+                    fn(e, ctx);
+            }
+            index = next;
+        }
+    }
+    if (now_tick >= m->tick)
+        m->tick = now_tick + 1;
+    if (expired)
+        restale(m);
+    pthread_mutex_unlock(&m->lock);
+    return expired;
+}
+
+uint64_t deadline_next(struct deadline_monitor *m) {
+    uint64_t next = UINT64_MAX;
+
+    pthread_mutex_lock(&m->lock);
+    uint32_t first = m->tick % DEADLINE_SLOTS;
+    // Occupied slots from the current one round the wheel; the first is the earliest tick
+    for (uint32_t w = 0; w <= DEADLINE_SLOTS / 64; w++) {
+        uint32_t word = (first / 64 + w) % (DEADLINE_SLOTS / 64);
+        uint64_t bits = m->occupied[word];
+        if (w == 0)
+            bits &= ~0ull << (first % 64);
+        else if (w == DEADLINE_SLOTS / 64)
+            bits &= (first % 64) ? ~0ull >> (64 - first % 64) : 0;
+        if (bits) {
+            uint32_t s = word * 64 + __builtin_ctzll(bits);
+            next = (m->tick + (s + DEADLINE_SLOTS - first) % DEADLINE_SLOTS) * DEADLINE_TICK_US;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&m->lock);
+    return next;
+}
+
+void deadline_stale(struct deadline_monitor *m, uint64_t *bits, uint32_t words) {
+    pthread_mutex_lock(&m->lock);
+    for (uint32_t w = 0; w < words; w++)
+        bits[w] = (w < m->stale_words) ? m->stale_bits[w] : 0;
+    pthread_mutex_unlock(&m->lock);
+}
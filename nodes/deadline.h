@@ -0,0 +1,92 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+ * Reception deadline monitoring on a single hashed timer wheel.
+ *
+ * Each monitored entry (a message, or one page of a multiplexed message)
+ * must arrive within its timeout. An arrival only stores its time: the
+ * entry stays in the wheel slot it was filed under, and when that slot
+ * comes up it is either re-filed at last arrival + timeout or, if that
+ * has passed, marked stale. Per frame that is one store, whatever the
+ * number of entries; the wheel is walked only as time passes, one slot
+ * per DEADLINE_TICK_US, and an entry is touched about once per timeout.
+ *
+ * A stale entry leaves the wheel and is filed again by its next arrival.
+ * Timeouts longer than one revolution simply come around several times.
+ * Each entry covers a list of the caller's bits (e.g. signal slots); the
+ * bits of all stale entries are kept as one bitmap, rebuilt only when an
+ * entry turns stale or fresh.
+ *
+ *   deadline_begin(&mon);
+ *   if (deadline_kick(&mon, index, rx_us)) ... it was stale, now fresh
+ *   deadline_end(&mon);
+ *
+ *   deadline_tick(&mon, now_us, expired_fn, ctx);  // by deadline_next(&mon)
+ */
+
+#define DEADLINE_TICK_US  10000     // wheel resolution, expiry is at most one tick late
+#define DEADLINE_SLOTS    256       // 2.56 s per revolution
+#define DEADLINE_NONE     UINT32_MAX
+
+struct deadline_spec {
+    uint32_t id;                    // caller's, reported on expiry (e.g. the CAN id)
+    const uint32_t *bits;           // caller's bits the entry covers (e.g. slots), < n_bits
+    uint32_t n;
+    uint32_t timeout_ms;
+};
+
+struct deadline_entry {
+    uint64_t last_us;               // last arrival, or when monitoring began
+    uint32_t timeout_us;
+    uint32_t id;
+    uint32_t first_bit, n_bits;     // its bits: bits[first_bit .. + n_bits)
+    uint32_t next;                  // in its wheel slot, DEADLINE_NONE at the end
+    uint8_t  stale;
+};
+
+struct deadline_monitor {
+    pthread_mutex_t lock;
+
+    struct deadline_entry *entry;
+    uint32_t n;
+    uint32_t *bits;                 // of all entries
+    uint32_t generation;            // of the configuration (signal database)
+
+    uint32_t head[DEADLINE_SLOTS];
+    uint64_t occupied[DEADLINE_SLOTS / 64];
+    uint64_t tick;                  // next tick to expire (time / DEADLINE_TICK_US)
+
+    uint64_t *stale_bits;           // bits of all stale entries
+    uint32_t stale_words;
+    uint32_t n_stale;
+    uint64_t expired, recovered;
+};
+
+void deadline_init(struct deadline_monitor *m);
+void deadline_free(struct deadline_monitor *m);
+
+// Replaces the entries if generation is newer than the current one; every entry
+// starts as if it just arrived. Bits are below n_bits. Returns 1 if replaced, 0 if
+// not newer, -1 on error
+int  deadline_configure(struct deadline_monitor *m, const struct deadline_spec *spec, uint32_t n,
+                        uint32_t n_bits, uint32_t generation, uint64_t now_us);
+
+// Arrivals: writers bracket a burst of kicks
+void deadline_begin(struct deadline_monitor *m);
+void deadline_end(struct deadline_monitor *m);
+int  deadline_kick(struct deadline_monitor *m, uint32_t index, uint64_t rx_us);    // 1 if it was stale
+
+// Expires what is overdue, calling fn for each entry that turns stale (under the lock);
+// returns how many did. Takes the lock
+int  deadline_tick(struct deadline_monitor *m, uint64_t now_us,
+                   void (*fn)(const struct deadline_entry *e, void *ctx), void *ctx);
+// Next time deadline_tick() may have work, UINT64_MAX if nothing is monitored
+uint64_t deadline_next(struct deadline_monitor *m);
+// Copies the stale bitmap into words of bits, zero past the monitor's
+void deadline_stale(struct deadline_monitor *m, uint64_t *bits, uint32_t words);
+
+#endif
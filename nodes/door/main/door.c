@@ -4,9 +4,11 @@
  * CAN ID: 0x102
  */
 
+#include <string.h>
 #include "driver/twai.h"
 #include "driver/gpio.h"
 #include "../../can_header.h"
+#include "../../secoc.h"
 #include "soc/gpio_num.h"
 
 #define TX_PIN GPIO_NUM_21
@@ -14,12 +16,29 @@
 #define DOOR_PIN GPIO_NUM_25
 #define SEATBELT_PIN GPIO_NUM_26
 
+// 1: responses carry freshness + CMAC for a dashboard started with -k
+#define SECOC_ENABLE 0
+
 void app_main(void) {
 
   int door_status,seatbelt_status;
   esp_err_t ret;
   twai_message_t message;
 
+  struct secoc_key sec_key;
+  struct secoc_tx_state sec_tx;
+  uint8_t raw_key[SECOC_KEY_LEN];
+
+  if(SECOC_ENABLE){
+    if(secoc_key_load(raw_key) < 0){
+      printf("SecOC enabled but no key provisioned (NVS secoc/key), not starting\n");
+      return;
+    }
+    secoc_key_init(&sec_key, raw_key);
+    memset(raw_key, 0, sizeof(raw_key));
+    sec_tx.freshness = secoc_boot_freshness();
+  }
+
   //Configure GPIO
   gpio_set_direction(DOOR_PIN, GPIO_MODE_INPUT);
   gpio_pullup_en(DOOR_PIN);
@@ -60,6 +79,8 @@ void app_main(void) {
         message.rtr = 0;
         message.data_length_code = 1;
       }
+      if(SECOC_ENABLE && secoc_authenticated(message.identifier))
+        message.data_length_code = secoc_protect(&sec_key, &sec_tx, message.identifier, message.data, 1);
       twai_transmit(&message, portMAX_DELAY);
     }
   }
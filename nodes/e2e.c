@@ -0,0 +1,246 @@
+#include <string.h>
+#include "e2e.h"
+#include "can_header.h"
+
+// ============ Profiles ============
+// Messages without an entry are sent and accepted unprotected
+static const struct e2e_profile e2e_profiles[] = {
+    {ENGINE_CAN_ID, E2E_CRC8,  1},  // EN_ON / EN_OFF
+    {BCM_CAN_ID,    E2E_CRC16, 3},  // BCM_CMD_WORD, lamps, mask
+};
+
+const struct e2e_profile *e2e_profile_lookup(uint32_t can_id) {
+    for (size_t i = 0; i < sizeof(e2e_profiles) / sizeof(e2e_profiles[0]); i++)
+        if (e2e_profiles[i].can_id == can_id)
+            return &e2e_profiles[i];
+    return NULL;
+}
+
+// ============ CRC Tables ============
+// table[k][b]: CRC contribution of byte b followed by k zero bytes. Four
+// tables, not eight: the inputs are 4 (engine) and 6 (BCM) bytes long
+static uint8_t  crc8_table[4][256];
+static uint16_t crc16_table[4][256];
+
+void e2e_init(void) {
+    for (int i = 0; i < 256; i++) {
+        uint8_t c8 = i;
+        uint16_t c16 = i << 8;
+
+        for (int b = 0; b < 8; b++) {
+            c8  = (c8 & 0x80)    ? (c8 << 1) ^ 0x1D    : (c8 << 1);
+            c16 = (c16 & 0x8000) ? (c16 << 1) ^ 0x1021 : (c16 << 1);
+        }
+        crc8_table[0][i]  = c8;
+        crc16_table[0][i] = c16;
+    }
+
+    for (int k = 1; k < 4; k++) {
+        for (int i = 0; i < 256; i++) {
+            crc8_table[k][i]  = crc8_table[0][crc8_table[k - 1][i]];
+            crc16_table[k][i] = (crc16_table[k - 1][i] << 8) ^ crc16_table[0][crc16_table[k - 1][i] >> 8];
+        }
+    }
+}
+
+// ============ CRC-8 SAE J1850 ============
+uint8_t e2e_crc8(const uint8_t *p, size_t len) {
+    uint8_t crc = 0xFF;
+
+    while (len >= 4) {
+        crc = crc8_table[3][crc ^ p[0]] ^ crc8_table[2][p[1]] ^ crc8_table[1][p[2]] ^ crc8_table[0][p[3]];
+        p   += 4;
+        len -= 4;
+    }
+    while (len--)
+        crc = crc8_table[0][crc ^ *p++];
+    return crc ^ 0xFF;
+}
+
+uint8_t e2e_crc8_bytewise(const uint8_t *p, size_t len) {
+    uint8_t crc = 0xFF;
+    while (len--)
+        crc = crc8_table[0][crc ^ *p++];
+    return crc ^ 0xFF;
+}
+
+// ============ CRC-16 CCITT-FALSE ============
+uint16_t e2e_crc16(const uint8_t *p, size_t len) {
+    uint16_t crc = 0xFFFF;
+
+    while (len >= 4) {
+        crc = crc16_table[3][(crc >> 8) ^ p[0]] ^ crc16_table[2][(crc & 0xFF) ^ p[1]] ^
+              crc16_table[1][p[2]] ^ crc16_table[0][p[3]];
+        p   += 4;
+        len -= 4;
+    }
+    while (len--)
+        crc = (crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p++];
+    return crc;
+}
+
+uint16_t e2e_crc16_bytewise(const uint8_t *p, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--)
+        crc = (crc << 8) ^ crc16_table[0][(crc >> 8) ^ *p++];
+    return crc;
+}
+
+// ============ Protect / Check ============
+static size_t crc_size(const struct e2e_profile *p) {
+    return (p->type == E2E_CRC16) ? 2 : 1;
+}
+
+// CRC over the 16-bit data id + payload + counter: at most 2 + 6 + 1 bytes,
+// as e2e_protect() leaves at least one CRC byte in the frame
+static uint16_t frame_crc(const struct e2e_profile *p, const uint8_t *data) {
+    uint8_t buf[9];
+
+    buf[0] = (p->can_id >> 8) & 0xFF;
+    buf[1] = p->can_id & 0xFF;
+    memcpy(buf + 2, data, p->data_len + 1);
+
+    if (p->type == E2E_CRC16)
+        return e2e_crc16(buf, p->data_len + 3);
+    return e2e_crc8(buf, p->data_len + 3);
+}
+
+int e2e_protect(const struct e2e_profile *p, struct e2e_tx_state *tx, uint8_t data[8]) {
+    if (p == NULL || p->type == E2E_NONE)
+        return p ? p->data_len : -1;
+    if (p->data_len + 1 + crc_size(p) > 8)
+        return -1;
+
+    data[p->data_len] = tx->counter++;
+
+    uint16_t crc = frame_crc(p, data);
+    if (p->type == E2E_CRC16) {
+        data[p->data_len + 1] = crc >> 8;
+        data[p->data_len + 2] = crc & 0xFF;
+    } else
+        data[p->data_len + 1] = crc;
+
+    return p->data_len + 1 + crc_size(p);
+}
+
+int e2e_sync(const struct e2e_profile *p, struct e2e_tx_state *tx, uint8_t data[8]) {
+    if (p == NULL || p->type == E2E_NONE || p->data_len == 0)
+        return -1;
+    memset(data, E2E_SYNC, p->data_len);
+    return e2e_protect(p, tx, data);
+}
+
+static int is_sync(const struct e2e_profile *p, const uint8_t *data) {
+    for (int i = 0; i < p->data_len; i++)
+        if (data[i] != E2E_SYNC)
+            return 0;
+    return p->data_len > 0;
+}
+
+int e2e_check(const struct e2e_profile *p, struct e2e_rx_state *rx, const uint8_t *data, uint8_t dlc) {
+    if (p == NULL || p->type == E2E_NONE)
+        return E2E_OK;
+    if (dlc < p->data_len + 1 + crc_size(p) || p->data_len + 1 + crc_size(p) > 8)
+        return E2E_ERR_LENGTH;
+
+    uint16_t crc = frame_crc(p, data);
+    uint16_t rx_crc = (p->type == E2E_CRC16) ? (data[p->data_len + 1] << 8) | data[p->data_len + 2]
+                                             : data[p->data_len + 1];
+    if (crc != rx_crc)
+        return E2E_ERR_CRC;
+
+    uint8_t counter = data[p->data_len];
+    if (is_sync(p, data)) {
+        rx->synced         = 1;
+        rx->resync_pending = 0;
+        rx->last_counter   = counter;
+        return E2E_SYNCED;
+    }
+    if (!rx->synced) {
+        rx->synced       = 1;
+        rx->last_counter = counter;
+        return E2E_OK;
+    }
+
+    uint8_t delta = counter - rx->last_counter;
+    if (delta == 0)
+        return E2E_ERR_REPEATED;
+
+    if (delta > E2E_MAX_DELTA) {
+        // Sender restarted: accept once two consecutive frames agree
+        if (rx->resync_pending && counter == (uint8_t)(rx->resync_counter + 1)) {
+            rx->resync_pending = 0;
+            rx->last_counter   = counter;
+            return E2E_OK;
+        }
+        rx->resync_pending = 1;
+        rx->resync_counter = counter;
+        return E2E_ERR_SEQUENCE;
+    }
+
+    rx->resync_pending = 0;
+    rx->last_counter   = counter;
+    return E2E_OK;
+}
+
+const char *e2e_strerror(int err) {
+    switch (err) {
+        case E2E_OK:           return "ok";
+        case E2E_ERR_LENGTH:   return "frame too short";
+        case E2E_ERR_CRC:      return "CRC mismatch";
+        case E2E_ERR_REPEATED: return "repeated counter";
+        case E2E_ERR_SEQUENCE: return "counter out of sequence";
+        case E2E_SYNCED:       return "synced";
+        default:               return "unknown";
+    }
+}
+
+// ============ Rejection Reports ============
+// data[0..1] command id (big-endian), data[2] -err, data[3] counter, data[4] state
+int e2e_report_encode(const struct e2e_profile *p, int err, const uint8_t *data, uint8_t dlc,
+                      uint8_t state, uint8_t out[8]) {
+    memset(out, 0, 8);
+    out[0] = (p->can_id >> 8) & 0xFF;
+    out[1] = p->can_id & 0xFF;
+    out[2] = (uint8_t)-err;
+    out[3] = (dlc > p->data_len) ? data[p->data_len] : 0;
+    out[4] = state;
+    return 5;
+}
+
+int e2e_report_decode(const uint8_t *data, uint8_t dlc, struct e2e_report *r) {
+    if (dlc < 5 || data[2] == 0)
+        return -1;
+    r->can_id  = ((uint32_t)data[0] << 8) | data[1];
+    r->err     = -(int)data[2];
+    r->counter = data[3];
+    r->state   = data[4];
+    return 0;
+}
+
+// ============ Benchmark ============
+// Times the first profile of that type, so the CRC input is a real frame's length
+double e2e_benchmark(int type, uint32_t iterations, uint64_t (*now_us)(void)) {
+    struct e2e_profile p = {0x102, (uint8_t)type, 1};
+
+    for (size_t i = 0; i < sizeof(e2e_profiles) / sizeof(e2e_profiles[0]); i++) {
+        if (e2e_profiles[i].type == type) {
+            p = e2e_profiles[i];
+            break;
+        }
+    }
+    struct e2e_tx_state tx = {0};
+    struct e2e_rx_state rx = {0};
+    uint8_t data[8] = {0x08};
+    volatile int sink = 0;
+
+    uint64_t t0 = now_us();
+    for (uint32_t i = 0; i < iterations; i++) {
+        e2e_protect(&p, &tx, data);
+        sink += e2e_check(&p, &rx, data, 8);
+    }
+    uint64_t t1 = now_us();
+
+    (void)sink;
+    return (t1 - t0) * 1000.0 / iterations;
+}
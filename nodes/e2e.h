@@ -0,0 +1,104 @@
+#ifndef E2E_H
+#define E2E_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * End-to-end protection for command frames.
+ *
+ * A protected frame carries the payload, then an alive counter byte, then
+ * the CRC (1 byte for CRC-8, 2 bytes big-endian for CRC-16):
+ *
+ *   data[0 .. len-1]  payload
+ *   data[len]         counter, +1 per frame
+ *   data[len+1 ..]    CRC over the 16-bit data id (CAN id) + payload + counter
+ *
+ * CRC-8 is SAE J1850 (poly 0x1D, init/xor 0xFF), CRC-16 is CCITT-FALSE
+ * (poly 0x1021, init 0xFFFF). Both take four bytes per step from slice-by-4
+ * tables built by e2e_init(): a CRC input is 4 bytes for the engine profile
+ * and 6 for the BCM, so one step plus at most two single bytes per frame.
+ * Portable C: shared by the Linux nodes and the ESP32 builds.
+ *
+ * Restarts. A receiver takes the counter of the first frame it sees, so a
+ * restarted receiver needs nothing. A restarted sender counts from 0 again,
+ * which the receiver would reject as repeated or out of sequence; so the
+ * sender opens every protected stream with a sync frame (e2e_sync()): a
+ * payload of E2E_SYNC bytes, counter and CRC as usual. e2e_check() adopts
+ * the counter of a sync frame with a valid CRC whatever it is, and returns
+ * E2E_SYNCED for the receiver to drop the frame. If the sync frame is lost,
+ * the first command is rejected and the one after it accepted (two
+ * consecutive counters resync the stream).
+ *
+ * Rejections. A receiver answers every rejected frame with a report on
+ * E2E_REPORT_CAN_ID (e2e_report_encode()): the command id, the error, the
+ * counter it got and its own state after the rejection, so the sender can
+ * tell the driver and correct what it assumed the command did.
+ */
+
+#define E2E_NONE   0
+#define E2E_CRC8   1
+#define E2E_CRC16  2
+
+// e2e_check() results
+#define E2E_OK            0
+#define E2E_ERR_LENGTH   -1  // frame too short for the profile
+#define E2E_ERR_CRC      -2  // corrupted
+#define E2E_ERR_REPEATED -3  // same counter as the last frame (stale/replayed)
+#define E2E_ERR_SEQUENCE -4  // counter jumped too far
+#define E2E_SYNCED        1  // valid sync frame, counter adopted; not a command
+
+#define E2E_MAX_DELTA    3   // frames that may be lost between two accepted ones
+#define E2E_SYNC         0xFF // every payload byte of a sync frame, never a command
+
+struct e2e_profile {
+    uint32_t can_id;
+    uint8_t  type;           // E2E_NONE / E2E_CRC8 / E2E_CRC16
+    uint8_t  data_len;       // protected payload bytes before the counter
+};
+
+struct e2e_tx_state {
+    uint8_t counter;
+};
+
+struct e2e_rx_state {
+    uint8_t last_counter;
+    uint8_t synced;
+    uint8_t resync_counter;  // candidate counter after a sequence error
+    uint8_t resync_pending;
+};
+
+// Decoded E2E_REPORT_CAN_ID frame
+struct e2e_report {
+    uint32_t can_id;         // rejected command's id
+    int      err;            // E2E_ERR_*
+    uint8_t  counter;        // as received, 0 if the frame was too short to hold one
+    uint8_t  state;          // receiver's state after the rejection, per node
+};
+
+void e2e_init(void);
+const struct e2e_profile *e2e_profile_lookup(uint32_t can_id);
+
+// Returns the protected frame length (new DLC), or -1 if it does not fit
+int e2e_protect(const struct e2e_profile *p, struct e2e_tx_state *tx, uint8_t data[8]);
+// Fills data with a sync frame; returns its length as e2e_protect() does
+int e2e_sync(const struct e2e_profile *p, struct e2e_tx_state *tx, uint8_t data[8]);
+int e2e_check(const struct e2e_profile *p, struct e2e_rx_state *rx, const uint8_t *data, uint8_t dlc);
+const char *e2e_strerror(int err);
+
+// Report of a frame e2e_check() rejected with err; returns the report's length
+int e2e_report_encode(const struct e2e_profile *p, int err, const uint8_t *data, uint8_t dlc,
+                      uint8_t state, uint8_t out[8]);
+// Returns 0, or -1 if the frame is not a report
+int e2e_report_decode(const uint8_t *data, uint8_t dlc, struct e2e_report *r);
+
+// CRC primitives, init and final xor included (slice-by-4 and byte-at-a-time reference)
+uint8_t  e2e_crc8(const uint8_t *data, size_t len);
+uint16_t e2e_crc16(const uint8_t *data, size_t len);
+uint8_t  e2e_crc8_bytewise(const uint8_t *data, size_t len);
+uint16_t e2e_crc16_bytewise(const uint8_t *data, size_t len);
+
+// Time per protected frame in ns, using the caller's microsecond clock
+double e2e_benchmark(int type, uint32_t iterations, uint64_t (*now_us)(void));
+
+#endif
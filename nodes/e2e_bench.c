@@ -0,0 +1,86 @@
+/*
+ * e2e_bench - End-to-end protection cost
+ * Checks the CRC implementations against their standard check values and
+ * reports the time per frame for byte-at-a-time vs slice-by-4 CRCs and for
+ * a full protect + check round trip. Each CRC is timed on the input length
+ * of the profile that uses it: 4 bytes for the engine's CRC-8, 6 for the
+ * BCM's CRC-16.
+ *
+ *   e2e_bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "can_header.h"
+#include "e2e.h"
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// CRC input of a profile's frame: data id + payload + counter
+static size_t crc_input_len(uint32_t can_id) {
+    const struct e2e_profile *p = e2e_profile_lookup(can_id);
+    return p ? 2 + p->data_len + 1 : 0;
+}
+
+// ns per CRC over a len-byte input
+static double time_crc(uint32_t (*crc)(const uint8_t *, size_t), size_t len, uint32_t frames) {
+    uint8_t buf[9] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+    volatile uint32_t sink = 0;
+
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < frames; i++) {
+        buf[2] = i;
+        sink += crc(buf, len);
+    }
+    uint64_t t1 = now_ns();
+
+    (void)sink;
+    return (double)(t1 - t0) / frames;
+}
+
+static uint32_t crc8_slice(const uint8_t *p, size_t n)  { return e2e_crc8(p, n); }
+static uint32_t crc8_byte(const uint8_t *p, size_t n)   { return e2e_crc8_bytewise(p, n); }
+static uint32_t crc16_slice(const uint8_t *p, size_t n) { return e2e_crc16(p, n); }
+static uint32_t crc16_byte(const uint8_t *p, size_t n)  { return e2e_crc16_bytewise(p, n); }
+
+int main(int argc, char *argv[]) {
+    const uint8_t check[] = "123456789";
+    uint32_t frames = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000000;
+
+    if (frames == 0) {
+        fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+        return 1;
+    }
+
+    e2e_init();
+    size_t engine_len = crc_input_len(ENGINE_CAN_ID), bcm_len = crc_input_len(BCM_CAN_ID);
+    if (engine_len < 3 || engine_len > 9 || bcm_len < 3 || bcm_len > 9) {
+        fprintf(stderr, "No engine or BCM profile to time\n");
+        return 1;
+    }
+
+    if (e2e_crc8(check, 9) != 0x4B || e2e_crc8_bytewise(check, 9) != 0x4B ||
+        e2e_crc16(check, 9) != 0x29B1 || e2e_crc16_bytewise(check, 9) != 0x29B1) {
+        fprintf(stderr, "CRC check values do not match\n");
+        return 1;
+    }
+
+    printf("CRC-8  bytewise   (%zu bytes) : %6.2f ns/frame\n", engine_len, time_crc(crc8_byte, engine_len, frames));
+    printf("CRC-8  slice-by-4 (%zu bytes) : %6.2f ns/frame\n", engine_len, time_crc(crc8_slice, engine_len, frames));
+    printf("CRC-16 bytewise   (%zu bytes) : %6.2f ns/frame\n", bcm_len, time_crc(crc16_byte, bcm_len, frames));
+    printf("CRC-16 slice-by-4 (%zu bytes) : %6.2f ns/frame\n", bcm_len, time_crc(crc16_slice, bcm_len, frames));
+    printf("E2E CRC-8  protect+check : %6.2f ns/frame\n", e2e_benchmark(E2E_CRC8, frames, now_us));
+    printf("E2E CRC-16 protect+check : %6.2f ns/frame\n", e2e_benchmark(E2E_CRC16, frames, now_us));
+    return 0;
+}
@@ -1,17 +1,115 @@
 /*
  * engine.c - Engine Node
- * Listens for engine start/stop commands from dashboard
- * CAN ID: 0x102
+ * Listens for engine start/stop commands from dashboard and sends
+ * rpm + battery voltage every ENGINE_DATA_PERIOD_MS
+ * CAN ID: 0x102 (commands), 0x090 (engine data)
  */
 
+#include <string.h>
 #include "driver/twai.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 #include "can_header.h"
+#include "../../e2e.h"
+#include "../../secoc.h"
 
 #define TX_PIN GPIO_NUM_21
 #define RX_PIN GPIO_NUM_22
 
+// Set to a frame count to time E2E protect + check at boot
+#define E2E_BENCH_FRAMES 0
+
+// 1: commands must carry a valid CMAC + freshness (dashboard -k) instead of E2E
+#define SECOC_ENABLE 0
+#define SECOC_BENCH_FRAMES 0
+
+// Simulated engine until the crank sensor and battery ADC are wired
+#define IDLE_RPM 850
+#define CRANK_RPM 250
+#define CRANK_US 400000 // starter runs this long after Engine ON
+#define BATTERY_MV 12600 // resting
+#define CRANK_MV 10500 // under starter load
+#define CHARGING_MV 14100 // alternator running
+
+// Set by the receive loop, read by the engine data timer
+static volatile int engine_on = 0;
+static volatile uint64_t engine_on_us = 0;
+
+static uint64_t now_us(void) {
+  return esp_timer_get_time();
+}
+
+// Small deterministic jitter in -range..range
+static int jitter(int range) {
+  static uint32_t seed = 1;
+  seed = seed * 1103515245 + 12345;
+  return (int)((seed >> 16) % (2 * range + 1)) - range;
+}
+
+// Runs in the esp_timer task every ENGINE_DATA_PERIOD_MS. Never blocks: if the TX
+// queue is full this sample is dropped and the next one goes out on time
+static void engine_data_tx(void *arg) {
+  static int32_t rpm = 0;
+  (void)arg;
+
+  int cranking = engine_on && now_us() - engine_on_us < CRANK_US;
+  int32_t target = !engine_on ? 0 : cranking ? CRANK_RPM : IDLE_RPM;
+  int32_t mv = !engine_on ? BATTERY_MV : cranking ? CRANK_MV : CHARGING_MV;
+
+  rpm += (target - rpm) / 8; // the engine spins up and down over a few hundred ms
+  if(rpm < 8 && target == 0)
+    rpm = 0;
+
+  int32_t rpm_out = (rpm > 0) ? rpm + jitter(10) : 0;
+  int32_t mv_out = mv + jitter(20);
+  if(rpm_out < 0)
+    rpm_out = 0;
+
+  twai_message_t message = {.identifier = ENGINE_DATA_CAN_ID, .data_length_code = 8};
+  message.data[0] = rpm_out >> 8;
+  message.data[1] = rpm_out & 0xFF;
+  message.data[2] = mv_out >> 8;
+  message.data[3] = mv_out & 0xFF;
+  twai_transmit(&message, 0);
+}
+
 void app_main(void) {
 
+  e2e_init();
+  if(E2E_BENCH_FRAMES > 0){
+    printf("E2E CRC8  : %.0f ns/frame\n", e2e_benchmark(E2E_CRC8, E2E_BENCH_FRAMES, now_us));
+    printf("E2E CRC16 : %.0f ns/frame\n", e2e_benchmark(E2E_CRC16, E2E_BENCH_FRAMES, now_us));
+  }
+
+  const struct e2e_profile *cmd_profile = e2e_profile_lookup(ENGINE_CAN_ID);
+  struct e2e_rx_state cmd_rx = {0};
+
+  // Last accepted freshness survives resets, so recorded commands cannot be replayed
+  struct secoc_key sec_key;
+  struct secoc_rx_state sec_rx = {0};
+  uint8_t raw_key[SECOC_KEY_LEN];
+
+  if(SECOC_ENABLE){
+    if(secoc_key_load(raw_key) < 0){
+      printf("SecOC enabled but no key provisioned (NVS secoc/key), not starting\n");
+      return;
+    }
+    secoc_key_init(&sec_key, raw_key);
+    memset(raw_key, 0, sizeof(raw_key));
+    secoc_rx_restore(&sec_rx, "engine_rx");
+  }
+
+  // Timing only: any key will do
+  if(SECOC_BENCH_FRAMES > 0){
+    struct secoc_key bench_key;
+    double protect_ns, verify_ns;
+    esp_fill_random(raw_key, sizeof(raw_key));
+    secoc_key_init(&bench_key, raw_key);
+    secoc_benchmark(&bench_key, SECOC_BENCH_FRAMES, now_us, &protect_ns, &verify_ns);
+    printf("SecOC %s : protect %.0f ns, verify %.0f ns\n", secoc_aes_impl(), protect_ns, verify_ns);
+    secoc_key_free(&bench_key);
+  }
+
   twai_general_config_t g = TWAI_GENERAL_CONFIG_DEFAULT(TX_PIN, RX_PIN, TWAI_MODE_NORMAL);
   twai_timing_config_t t  = TWAI_TIMING_CONFIG_500KBITS();
   twai_filter_config_t f  = TWAI_FILTER_CONFIG_ACCEPT_ALL();
@@ -29,6 +127,14 @@ void app_main(void) {
     return;
   }
 
+  const esp_timer_create_args_t data_timer_args = {.callback = engine_data_tx, .name = "engine_data"};
+  esp_timer_handle_t data_timer;
+  if(esp_timer_create(&data_timer_args, &data_timer) != ESP_OK ||
+     esp_timer_start_periodic(data_timer, ENGINE_DATA_PERIOD_MS * 1000) != ESP_OK){
+    printf("Failed to start engine data timer\n");
+    return;
+  }
+
   twai_message_t message;
 
   while(1){
@@ -36,10 +142,41 @@ void app_main(void) {
 
     if(ret == ESP_OK){
       if(message.identifier == ENGINE_CAN_ID){
-        if(message.data[0] == 0x08)
+        if(SECOC_ENABLE){
+          int len = secoc_verify(&sec_key, &sec_rx, ENGINE_CAN_ID, message.data, message.data_length_code);
+          if(len < 1){
+            printf("Engine command rejected: %s\n", secoc_strerror(len));
+            continue;
+          }
+          if(secoc_rx_persist(&sec_rx, "engine_rx") < 0){
+            printf("Engine command dropped: freshness not stored\n");
+            continue;
+          }
+        }else{
+          // Rejections go back to the dashboard with the engine's state; sync frames only set the counter
+          int err = e2e_check(cmd_profile, &cmd_rx, message.data, message.data_length_code);
+          if(err < 0){
+            printf("Engine command rejected: %s\n", e2e_strerror(err));
+            twai_message_t report = {.identifier = E2E_REPORT_CAN_ID};
+            report.data_length_code = e2e_report_encode(cmd_profile, err, message.data, message.data_length_code,
+                                                        engine_on, report.data);
+            twai_transmit(&report, 0);
+            continue;
+          }
+          if(err == E2E_SYNCED)
+            continue;
+        }
+
+        if(message.data[0] == EN_ON){
+          if(!engine_on){
+            engine_on_us = now_us();
+            engine_on = 1;
+          }
           printf("Engine ON\n");
-        else if(message.data[0] == 0x00)
+        }else if(message.data[0] == EN_OFF){
+          engine_on = 0;
           printf("Engine OFF\n");
+        }
       }
     }
   }
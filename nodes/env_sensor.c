@@ -0,0 +1,139 @@
+/*
+ * env_sensor.c - Environment Node
+ * Publishes slow-changing values through the multiplexed ENV_MUX_CAN_ID,
+ * rotating through the pages on a configurable schedule.
+ * CAN ID: 0x0A0
+ *
+ *   env_sensor [-d signal_db] [-p page:period_ms ...]     e.g. -p 0:500 -p 1:10000
+ *
+ * The page layouts and default periods come from the signal database
+ * (built in, or -d signals.db / .sdb), the one the dashboard decodes with.
+ */
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include "can_header.h"
+#include "can_utils.h"
+#include "signal_codec.h"
+#include "signal_db.h"
+
+int can_socket;
+
+static uint64_t now_ms(void);
+static void sample_page(const struct can_mux_page *page, uint64_t t, int64_t *raw);
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Bench values with a slow drift until the analog front end is wired
+static void sample_page(const struct can_mux_page *page, uint64_t t, int64_t *raw) {
+  int drift = (t / 1000) % 60;
+
+  for (size_t i = 0; i < page->count; i++) {
+    const struct can_signal *sig = &page->signals[i];
+    double value = 0;
+
+    if (strcmp(sig->name, "ambient_temp") == 0)      value = 18.0 + drift * 0.1;
+    else if (strcmp(sig->name, "cabin_temp") == 0)   value = 22.0 + drift * 0.05;
+    else if (strcmp(sig->name, "fuel_level") == 0)   value = 75.0 - drift * 0.5;
+    else if (strcmp(sig->name, "oil_pressure") == 0) value = 300.0 + drift;
+
+    raw[i] = signal_raw_from_phys(sig, value);
+  }
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [-d signal_db] [-p page:period_ms ...]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+  struct can_frame frame;
+  struct can_mux_schedule sched;
+  int64_t raw[64];
+  const char *db_path = NULL;
+  unsigned sel[256], period[256];
+  int n_periods = 0;
+  int opt;
+
+  // Override page periods: -p <selector>:<period_ms>, period 0 disables a page
+  while ((opt = getopt(argc, argv, "d:p:")) != -1) {
+    if (opt == 'd') {
+      db_path = optarg;
+    } else if (opt != 'p' || n_periods == 256 ||
+               sscanf(optarg, "%u:%u", &sel[n_periods], &period[n_periods]) != 2 || sel[n_periods] > 255) {
+      usage(argv[0]);
+      return 1;
+    } else {
+      n_periods++;
+    }
+  }
+
+  struct signal_db *db = db_path ? signal_db_load(db_path)
+                                 : signal_db_load_text(signal_db_default_text);
+  if (db == NULL)
+    return 1;
+
+  const struct signal_db_message *msg = signal_db_message(db, ENV_MUX_CAN_ID);
+  const struct can_mux_message *env = msg ? msg->mux : NULL;
+  if (env == NULL) {
+    fprintf(stderr, "No multiplexed message 0x%03X in the signal database\n", ENV_MUX_CAN_ID);
+    signal_db_free(db);
+    return 1;
+  }
+
+  can_mux_schedule_init(&sched, env, now_ms());
+  for (int i = 0; i < n_periods; i++) {
+    if (env->dispatch[sel[i]] < 0) {
+      usage(argv[0]);
+      signal_db_free(db);
+      return 1;
+    }
+    sched.period_ms[env->dispatch[sel[i]]] = period[i];
+  }
+
+  // Transmit only
+  struct can_filter env_filter[1] = {
+    {.can_id = 0, .can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG}
+  };
+
+  can_socket = initialize_can_socket(CAN_INF, env_filter, sizeof(env_filter));
+  if (can_socket < 0) {
+    fprintf(stderr, "Failed to initialize CAN socket\n");
+    signal_db_free(db);
+    return 1;
+  }
+
+  while (1) {
+    uint64_t t = now_ms();
+    int idx = can_mux_schedule_next(&sched, t);
+
+    if (idx < 0) {
+      usleep(can_mux_schedule_wait_ms(&sched, t) * 1000);
+      continue;
+    }
+
+    const struct can_mux_page *page = &env->pages[idx];
+    sample_page(page, t, raw);
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id  = ENV_MUX_CAN_ID;
+    frame.can_dlc = 8;
+    can_mux_encode(env, page->selector, raw, frame.data);
+
+    if (write(can_socket, &frame, sizeof(frame)) < 0)
+      perror("write failed");
+  }
+
+  close(can_socket);
+  signal_db_free(db);
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * filter_bench - Smoothing filter throughput
+ * Checks that the vector and scalar filter steps agree sample for sample,
+ * then reports samples per second for each filter across a bank of
+ * signals, every signal getting one noisy sample per tick.
+ *
+ *   filter_bench [signals] [ticks]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "signal_filter.h"
+
+#define INPUT_TICKS 64      // input table, replayed
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// A slow ramp per signal with +-500 raw of noise, the odd spike and the odd garbage value
+static int32_t *make_input(uint32_t signals) {
+    int32_t *in = malloc((size_t)signals * INPUT_TICKS * sizeof(*in));
+    uint32_t seed = 12345;
+
+    if (in == NULL)
+        return NULL;
+    for (uint32_t t = 0; t < INPUT_TICKS; t++)
+        for (uint32_t s = 0; s < signals; s++) {
+            seed = seed * 1103515245 + 12345;
+            int32_t noise = (int32_t)((seed >> 16) % 1001) - 500;
+            if ((seed >> 8) % 61 == 0)
+                noise *= 20;
+            in[(size_t)t * signals + s] = 9000 + (int32_t)(s % 100) * 10 + (int32_t)t * 3 + noise;
+            if ((seed >> 4) % 509 == 0)     // a garbage frame, beyond the filters' range
+                in[(size_t)t * signals + s] = (seed & 1) ? INT32_MAX : INT32_MIN;
+        }
+    return in;
+}
+
+static void spec_fill(struct filter_spec *spec, uint32_t signals, const struct filter_spec *kinds, int n_kinds) {
+    for (uint32_t s = 0; s < signals; s++)
+        spec[s] = kinds[s % n_kinds];
+}
+
+static int check(const struct filter_spec *spec, uint32_t signals, const int32_t *in) {
+    struct filter_bank vec, ref;
+    int ok = 1;
+
+    if (filter_bank_init(&vec, spec, signals) < 0 || filter_bank_init(&ref, spec, signals) < 0) {
+        fprintf(stderr, "filter_bank_init failed\n");
+        return 0;
+    }
+    for (uint32_t t = 0; t < 4 * INPUT_TICKS && ok; t++) {
+        const int32_t *row = in + (size_t)(t % INPUT_TICKS) * signals;
+        for (uint32_t s = 0; s < signals; s++) {
+            if ((t + s) % 7 == 3)   // some signals miss a tick
+                continue;
+            filter_bank_put(&vec, s, row[s]);
+            filter_bank_put(&ref, s, row[s]);
+        }
+        filter_bank_step(&vec);
+        filter_bank_step_scalar(&ref);
+        for (uint32_t s = 0; s < signals; s++)
+            if (filter_bank_get(&vec, s) != filter_bank_get(&ref, s)) {
+                fprintf(stderr, "mismatch: tick %u signal %u: %d vs %d\n", t, s,
+                        filter_bank_get(&vec, s), filter_bank_get(&ref, s));
+                ok = 0;
+                break;
+            }
+    }
+    filter_bank_free(&vec);
+    filter_bank_free(&ref);
+    return ok;
+}
+
+// Millions of samples per second, put and step included
+static double time_bank(const struct filter_spec *spec, uint32_t signals, uint32_t ticks,
+                        const int32_t *in, void (*step)(struct filter_bank *)) {
+    struct filter_bank b;
+    volatile int32_t sink = 0;
+
+    if (filter_bank_init(&b, spec, signals) < 0)
+        return 0;
+
+    uint64_t t0 = now_ns();
+    for (uint32_t t = 0; t < ticks; t++) {
+        const int32_t *row = in + (size_t)(t % INPUT_TICKS) * signals;
+        for (uint32_t s = 0; s < signals; s++)
+            filter_bank_put(&b, s, row[s]);
+        step(&b);
+    }
+    uint64_t t1 = now_ns();
+
+    sink += filter_bank_get(&b, 0);
+    (void)sink;
+    filter_bank_free(&b);
+    return (double)signals * ticks / ((t1 - t0) / 1e3);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t signals = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1024;
+    uint32_t ticks   = (argc > 2) ? strtoul(argv[2], NULL, 0) : 20000;
+
+    static const struct {
+        const char *name;
+        struct filter_spec kinds[4];
+        int n;
+    } runs[] = {
+        {"none",      {{FILTER_NONE, 0}}, 1},
+        {"ema:3",     {{FILTER_EMA, 3}}, 1},
+        {"median:3",  {{FILTER_MEDIAN, 3}}, 1},
+        {"median:5",  {{FILTER_MEDIAN, 5}}, 1},
+        {"median:7",  {{FILTER_MEDIAN, 7}}, 1},
+        {"rate:50",   {{FILTER_RATE, 50}}, 1},
+        {"mixed",     {{FILTER_EMA, 2}, {FILTER_MEDIAN, 5}, {FILTER_RATE, 100}, {FILTER_NONE, 0}}, 4},
+    };
+
+    if (signals == 0 || ticks == 0) {
+        fprintf(stderr, "Usage: %s [signals] [ticks]\n", argv[0]);
+        return 1;
+    }
+
+    int32_t *in = make_input(signals);
+    struct filter_spec *spec = malloc(signals * sizeof(*spec));
+    if (in == NULL || spec == NULL) {
+        perror("malloc failed");
+        return 1;
+    }
+
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        spec_fill(spec, signals, runs[r].kinds, runs[r].n);
+        if (!check(spec, signals, in)) {
+            fprintf(stderr, "%s: %s and scalar steps disagree\n", runs[r].name, filter_impl());
+            return 1;
+        }
+    }
+
+    printf("%u signals, %u ticks, Msamples/s\n", signals, ticks);
+    printf("%-10s %10s %10s\n", "filter", "scalar", filter_impl());
+    for (size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++) {
+        spec_fill(spec, signals, runs[r].kinds, runs[r].n);
+        double scalar = time_bank(spec, signals, ticks, in, filter_bank_step_scalar);
+        double vector = time_bank(spec, signals, ticks, in, filter_bank_step);
+        printf("%-10s %10.1f %10.1f\n", runs[r].name, scalar, vector);
+    }
+
+    free(in);
+    free(spec);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "histogram.h"
+
+static int bucket(uint64_t us) {
+    if (us < 4)
+        return (int)us;
+
+    int log = 63 - __builtin_clzll(us);
+    int b = 4 * (log - 1) + (int)((us >> (log - 2)) & 3);
+    return (b < HIST_BUCKETS) ? b : HIST_BUCKETS - 1;
+}
+
+// Exclusive upper bound of a bucket
+static uint64_t bucket_limit(int b) {
+    if (b < 4)
+        return (uint64_t)b + 1;
+    return (uint64_t)(4 + b % 4 + 1) << (b / 4 - 1);
+}
+
+void hist_add(struct histogram *h, uint64_t us) {
+    h->buckets[bucket(us)]++;
+    h->total++;
+}
+
+void hist_halve(struct histogram *h) {
+    h->total = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        h->buckets[b] /= 2;
+        h->total += h->buckets[b];
+    }
+}
+
+uint64_t hist_percentile(const struct histogram *h, int pct) {
+    if (h->total == 0)
+        return 0;
+
+    uint32_t need = (uint32_t)(((uint64_t)h->total * pct + 99) / 100), seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= need && seen > 0)
+            return bucket_limit(b);
+    }
+    return bucket_limit(HIST_BUCKETS - 1);
+}
+
+uint64_t hist_max(const struct histogram *h) {
+    for (int b = HIST_BUCKETS - 1; b >= 0; b--)
+        if (h->buckets[b])
+            return bucket_limit(b);
+    return 0;
+}
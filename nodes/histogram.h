@@ -0,0 +1,25 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/*
+ * Log-scale histogram for durations in microseconds: 0-3 us exact, then
+ * four buckets per power of two up to ~16 s (at most 25% above the true
+ * value). Percentiles report the upper bound of the bucket, so they err
+ * on the long side.
+ */
+
+#define HIST_BUCKETS  96
+
+struct histogram {
+    uint32_t total;
+    uint32_t buckets[HIST_BUCKETS];
+};
+
+void     hist_add(struct histogram *h, uint64_t us);
+void     hist_halve(struct histogram *h);    // ages old samples out
+uint64_t hist_percentile(const struct histogram *h, int pct);    // 0 if empty
+uint64_t hist_max(const struct histogram *h);
+
+#endif
@@ -0,0 +1,109 @@
+#include <string.h>
+#include "latency.h"
+
+static const char *const stage_names[LAT_HISTS] = {
+    "input->dispatch", "dispatch->write", "write->confirm", "total",
+};
+
+void latency_init(struct latency *lat, const char *const *names) {
+    memset(lat, 0, sizeof(*lat));
+    pthread_mutex_init(&lat->lock, NULL);
+    lat->names = names;
+}
+
+static void stamp(struct latency_trace *tr, int stage, uint64_t now_us) {
+    tr->t[stage] = now_us;
+    tr->stamped |= 1u << stage;
+}
+
+// Interval from stamp a to stamp b, if both were taken (clamped: kernel stamps may lead ours)
+static void record(struct latency *lat, int cmd, int hist, int a, int b) {
+    struct latency_trace *tr = &lat->trace[cmd];
+
+    if ((tr->stamped & (1u << a)) && (tr->stamped & (1u << b)))
+        hist_add(&lat->hist[cmd][hist], (tr->t[b] > tr->t[a]) ? tr->t[b] - tr->t[a] : 0);
+}
+
+void latency_input(struct latency *lat, int cmd, uint64_t now_us) {
+    if (cmd < 0 || cmd >= LAT_MAX_CMDS)
+        return;
+
+    pthread_mutex_lock(&lat->lock);
+    lat->trace[cmd].stamped = 0;
+    stamp(&lat->trace[cmd], LAT_INPUT, now_us);
+    pthread_mutex_unlock(&lat->lock);
+}
+
+void latency_dispatch(struct latency *lat, int cmd, uint64_t now_us) {
+    if (cmd < 0 || cmd >= LAT_MAX_CMDS)
+        return;
+
+    pthread_mutex_lock(&lat->lock);
+    stamp(&lat->trace[cmd], LAT_DISPATCH, now_us);
+    record(lat, cmd, LAT_INPUT, LAT_INPUT, LAT_DISPATCH);
+    pthread_mutex_unlock(&lat->lock);
+}
+
+void latency_write(struct latency *lat, int cmd, const struct can_frame *frame, uint64_t now_us) {
+    if (cmd < 0 || cmd >= LAT_MAX_CMDS)
+        return;
+
+    pthread_mutex_lock(&lat->lock);
+    struct latency_trace *tr = &lat->trace[cmd];
+    stamp(tr, LAT_WRITE, now_us);
+    tr->can_id = frame->can_id;
+    tr->dlc = frame->can_dlc;
+    memcpy(tr->data, frame->data, sizeof(tr->data));
+    record(lat, cmd, LAT_DISPATCH, LAT_DISPATCH, LAT_WRITE);
+    pthread_mutex_unlock(&lat->lock);
+}
+
+void latency_confirm(struct latency *lat, const struct can_frame *frame, uint64_t now_us) {
+    pthread_mutex_lock(&lat->lock);
+    for (int cmd = 0; cmd < LAT_MAX_CMDS; cmd++) {
+        struct latency_trace *tr = &lat->trace[cmd];
+
+        if ((tr->stamped & ((1u << LAT_WRITE) | (1u << LAT_CONFIRM))) != (1u << LAT_WRITE))
+            continue;
+        if (tr->can_id != frame->can_id || tr->dlc != frame->can_dlc ||
+            memcmp(tr->data, frame->data, frame->can_dlc) != 0)
+            continue;
+
+        stamp(tr, LAT_CONFIRM, now_us);
+        record(lat, cmd, LAT_WRITE, LAT_WRITE, LAT_CONFIRM);
+        record(lat, cmd, LAT_TOTAL, LAT_INPUT, LAT_CONFIRM);
+        pthread_mutex_unlock(&lat->lock);
+        return;
+    }
+    lat->unmatched++;
+    pthread_mutex_unlock(&lat->lock);
+}
+
+void latency_report(struct latency *lat, FILE *out) {
+    struct histogram hist[LAT_MAX_CMDS][LAT_HISTS];
+
+    // Copy under the lock, format outside it
+    pthread_mutex_lock(&lat->lock);
+    memcpy(hist, lat->hist, sizeof(hist));
+    uint64_t unmatched = lat->unmatched;
+    pthread_mutex_unlock(&lat->lock);
+
+    fprintf(out, "Command latency (us)           n      p50      p90      p99      max\n");
+    for (int cmd = 0; cmd < LAT_MAX_CMDS; cmd++) {
+        uint32_t samples = 0;
+        for (int s = 0; s < LAT_HISTS; s++)
+            samples += hist[cmd][s].total;
+        if (lat->names == NULL || lat->names[cmd] == NULL || samples == 0)
+            continue;
+
+        fprintf(out, "  %d. %s\n", cmd, lat->names[cmd]);
+        for (int s = 0; s < LAT_HISTS; s++) {
+            const struct histogram *h = &hist[cmd][s];
+            fprintf(out, "    %-20s %6u %8llu %8llu %8llu %8llu\n", stage_names[s], h->total,
+                    (unsigned long long)hist_percentile(h, 50), (unsigned long long)hist_percentile(h, 90),
+                    (unsigned long long)hist_percentile(h, 99), (unsigned long long)hist_max(h));
+        }
+    }
+    if (unmatched)
+        fprintf(out, "  %llu confirmations without a pending command\n", (unsigned long long)unmatched);
+}
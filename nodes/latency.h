@@ -0,0 +1,67 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <linux/can.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "histogram.h"
+
+/*
+ * Command latency, keypress to wire.
+ *
+ * Every command (menu option) carries one trace through four monotonic
+ * stamps:
+ *
+ *   input     the option was read from the terminal or a state socket client
+ *   dispatch  the dashboard started acting on it
+ *   write     the secured frame was handed to the socket
+ *   confirm   the frame came back as our own transmission
+ *
+ * The confirmation is matched to its trace by frame contents (the E2E
+ * counter / SecOC freshness make each one unique). Stage intervals and
+ * the total go into per-command histograms. Stamps arrive from several
+ * threads in the threaded dashboard, hence the lock.
+ */
+
+#define LAT_MAX_CMDS  16
+
+// Stamps
+#define LAT_INPUT     0
+#define LAT_DISPATCH  1
+#define LAT_WRITE     2
+#define LAT_CONFIRM   3
+#define LAT_STAMPS    4
+
+// Histograms per command: [s] covers stamp s -> s + 1, then the total
+#define LAT_TOTAL     (LAT_STAMPS - 1)
+#define LAT_HISTS     LAT_STAMPS
+
+struct latency_trace {
+    uint64_t t[LAT_STAMPS];
+    uint8_t  stamped;           // bit per stamp taken
+    uint32_t can_id;
+    uint8_t  dlc;
+    uint8_t  data[8];
+};
+
+struct latency {
+    pthread_mutex_t lock;
+    struct latency_trace trace[LAT_MAX_CMDS];
+    struct histogram hist[LAT_MAX_CMDS][LAT_HISTS];
+    uint64_t unmatched;         // confirmations without a waiting trace
+    const char *const *names;   // per command, NULL entries are skipped in reports
+};
+
+void latency_init(struct latency *lat, const char *const *names);
+
+// A new input starts a new trace for that command
+void latency_input(struct latency *lat, int cmd, uint64_t now_us);
+void latency_dispatch(struct latency *lat, int cmd, uint64_t now_us);
+void latency_write(struct latency *lat, int cmd, const struct can_frame *frame, uint64_t now_us);
+void latency_confirm(struct latency *lat, const struct can_frame *frame, uint64_t now_us);
+
+// n / p50 / p90 / p99 / max per command and stage
+void latency_report(struct latency *lat, FILE *out);
+
+#endif
@@ -0,0 +1,151 @@
+/*
+ * layout_bench - Widget layout frame cost against the number of signals
+ * Builds a database of N one-byte signals and a layout with one value
+ * widget per signal, then times frames in which a few signals change,
+ * render and flush (to /dev/null) included. Values come from an array
+ * indexed by signal, not from the dashboard's slots.
+ *
+ * Each size is timed twice: handing the renderer the set of slots that
+ * changed, as the dashboard's receive path does, and with no set, which
+ * reads every signal each frame. Only the latter grows with the database
+ * when the changes per frame stay the same.
+ *
+ *   layout_bench [changed per frame] [frames]
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "widget.h"
+
+#define BENCH_COLS      80
+#define WIDGET_COLS     20      // four widgets per row
+#define SIGNALS_PER_ID  8
+
+static int32_t *values;         // per database signal
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int array_value(const struct vehicle_state *vs, const struct signal_db *db, int32_t sig,
+                       int32_t *raw, int *stale) {
+    (void)vs;
+    (void)db;
+    *raw   = values[sig];
+    *stale = 0;
+    return 1;
+}
+
+// s0 .. s<n-1>, eight to a message from 0x100
+static struct signal_db *make_db(uint32_t n) {
+    size_t cap = 1 + (size_t)n * 48, len = 0;
+    char *text = malloc(cap);
+    struct signal_db *db = NULL;
+
+    if (text == NULL)
+        return NULL;
+    text[0] = '\0';
+    for (uint32_t s = 0; s < n; s++)
+        len += snprintf(text + len, cap - len, "sig s%u 0x%03X %u 8 le u 1 0 dec=0\n", s,
+                        0x100 + s / SIGNALS_PER_ID, s % SIGNALS_PER_ID * 8);
+    db = signal_db_load_text(text);
+    free(text);
+    return db;
+}
+
+// Microseconds per frame with `changed` signals moving each frame, told to the renderer
+// as a changed set if dirty is set; -1 on error
+static double run(uint32_t n, uint32_t changed, uint32_t frames, int dirty, int out, double *redrawn) {
+    struct signal_db *db = make_db(n);
+    struct widget *w = calloc(n, sizeof(*w));
+    char (*names)[16] = malloc(n * sizeof(*names));
+    uint64_t *set = calloc((n + 63) / 64, sizeof(*set));
+    const struct layout_source src = {.value = array_value};
+    struct vehicle_state *vs = vehicle_state_alloc(n);
+    struct screen scr;
+    struct layout l;
+    double us = -1;
+
+    values = calloc(n, sizeof(*values));
+    if (db == NULL || w == NULL || names == NULL || set == NULL || vs == NULL || values == NULL) {
+        fprintf(stderr, "%u signals: setup failed\n", n);
+        goto out;
+    }
+    for (uint32_t s = 0; s < n; s++) {
+        snprintf(names[s], sizeof(names[s]), "s%u", s);
+        w[s] = (struct widget){WIDGET_VALUE, s / 4, s % 4 * WIDGET_COLS, WIDGET_COLS, -1, .signal = names[s],
+                               .label = names[s], .text = {" u"}, .warn_lo = NAN, .warn_hi = NAN};
+    }
+    // Widget rows are 8 bits: at most 256 rows of four
+    if ((n + 3) / 4 > 256 || screen_init(&scr, (n + 3) / 4, BENCH_COLS) < 0) {
+        fprintf(stderr, "%u signals: no screen that tall\n", n);
+        goto out;
+    }
+    if (layout_init(&l, w, n, &src) < 0) {
+        screen_free(&scr);
+        goto out;
+    }
+
+    layout_render(&l, &scr, vs, db, NULL, 0);
+    screen_flush(&scr, out);
+
+    // Standalone databases: signal s is slot s
+    uint64_t widgets = 0, t0 = now_ns();
+    for (uint32_t f = 0; f < frames; f++) {
+        for (uint32_t c = 0; c < changed; c++) {
+            uint32_t s = (f * changed + c) * 7919u % n;
+            values[s]++;
+            set[s / 64] |= 1ull << (s % 64);
+        }
+        widgets += layout_render(&l, &scr, vs, db, dirty ? set : NULL, 0);
+        screen_flush(&scr, out);
+        for (uint32_t c = 0; c < changed; c++) {
+            uint32_t s = (f * changed + c) * 7919u % n;
+            set[s / 64] = 0;
+        }
+    }
+    us = (now_ns() - t0) / 1e3 / frames;
+    *redrawn = (double)widgets / frames;
+
+    layout_free(&l);
+    screen_free(&scr);
+out:
+    signal_db_free(db);
+    free(w);
+    free(names);
+    free(set);
+    free(vs);
+    free(values);
+    return us;
+}
+
+int main(int argc, char *argv[]) {
+    static const uint32_t sizes[] = {24, 256, 1024};
+    uint32_t changed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 4;
+    uint32_t frames  = (argc > 2) ? strtoul(argv[2], NULL, 0) : 20000;
+    int out = open("/dev/null", O_WRONLY);
+
+    if (frames == 0 || changed > sizes[0] || out < 0) {
+        fprintf(stderr, "Usage: %s [changed per frame, up to %u] [frames]\n", argv[0], sizes[0]);
+        return 1;
+    }
+
+    printf("%u changed signals per frame, %u frames\n", changed, frames);
+    printf("%8s %10s %10s %10s\n", "signals", "us/frame", "read all", "redrawn");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        double redrawn = 0, us = run(sizes[i], changed, frames, 1, out, &redrawn);
+        double all = run(sizes[i], changed, frames, 0, out, &redrawn);
+        if (us < 0 || all < 0)
+            return 1;
+        printf("%8u %10.2f %10.2f %10.1f\n", sizes[i], us, all, redrawn);
+    }
+    close(out);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <string.h>
+#include <unistd.h>
+#include "rtr.h"
+
+// ============ Round-trip Times ============
+static struct rtr_rtt *rtt_find(const struct rtr_timing *t, uint32_t id) {
+    for (int i = 0; i < t->n; i++)
+        if (t->nodes[i].id == id)
+            return (struct rtr_rtt *)&t->nodes[i];
+    return NULL;
+}
+
+void rtr_timing_init(struct rtr_timing *t, uint32_t floor_ms, uint32_t ceiling_ms) {
+    memset(t, 0, sizeof(*t));
+    t->floor_us   = floor_ms * 1000;
+    t->ceiling_us = ceiling_ms * 1000;
+}
+
+void rtr_rtt_add(struct rtr_timing *t, uint32_t id, uint64_t rtt_us) {
+    struct rtr_rtt *r = rtt_find(t, id);
+
+    if (r == NULL) {
+        if (t->n == RTR_CACHE_SIZE)
+            return;
+        r = &t->nodes[t->n++];
+        r->id = id;
+    }
+
+    if (r->hist.total >= RTR_RTT_WINDOW)
+        hist_halve(&r->hist);
+    hist_add(&r->hist, rtt_us);
+}
+
+uint64_t rtr_rtt_percentile(const struct rtr_timing *t, uint32_t id, int pct) {
+    const struct rtr_rtt *r = rtt_find(t, id);
+
+    if (r == NULL || r->hist.total < RTR_RTT_MIN_SAMPLES)
+        return 0;
+    return hist_percentile(&r->hist, pct);
+}
+
+// Every attempt fits in the ceiling, so a dead node costs at most the ceiling overall
+uint64_t rtr_attempt_timeout_us(const struct rtr_timing *t, uint32_t id) {
+    uint64_t cap = t->ceiling_us / RTR_ATTEMPTS;
+    uint64_t p = rtr_rtt_percentile(t, id, RTR_RTT_PERCENTILE);
+
+    if (p == 0)
+        return cap;
+
+    uint64_t timeout = p * RTR_RTT_FACTOR;
+    if (timeout < t->floor_us)
+        timeout = t->floor_us;
+    return (timeout < cap) ? timeout : cap;
+}
+
+// ============ Requests ============
+static int rtr_request_node(struct rtr_request *req, int i, uint64_t now_us) {
+    struct can_frame frame;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id  = req->ids[i] | CAN_RTR_FLAG;
+    frame.can_dlc = req->dlc;
+
+    req->attempts[i]++;
+    req->sent_us[i] = now_us;
+    req->deadline_us[i] = now_us + rtr_attempt_timeout_us(req->timing, req->ids[i]);
+    return write(req->fd, &frame, sizeof(frame)) == sizeof(frame);
+}
+
+int rtr_send(struct rtr_request *req, int fd, const uint32_t *ids, int n, uint8_t dlc,
+             uint64_t now_us, struct rtr_timing *timing) {
+    int sent = 0;
+
+    if (n > RTR_MAX_NODES)
+        n = RTR_MAX_NODES;
+
+    req->n = n;
+    req->fd = fd;
+    req->dlc = dlc;
+    req->timing = timing;
+    req->pending = (1u << n) - 1;
+    req->failed = 0;
+    req->shared = 0;
+
+    // A failed write is left to the deadline and the retry
+    for (int i = 0; i < n; i++) {
+        req->ids[i] = ids[i];
+        req->attempts[i] = 0;
+        sent += rtr_request_node(req, i, now_us);
+    }
+    return sent;
+}
+
+int rtr_match(struct rtr_request *req, const struct can_frame *frame, uint64_t rx_us) {
+    if (frame->can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG))
+        return -1;
+
+    uint32_t id = frame->can_id & CAN_SFF_MASK;
+    for (int i = 0; i < req->n; i++) {
+        if (req->ids[i] != id || !(req->pending & (1u << i)))
+            continue;
+
+        // After a retry, or with someone else's request in flight, the reply may answer
+        // another request, so it says nothing about the RTT
+        if (req->attempts[i] == 1 && !(req->shared & (1u << i)) && rx_us >= req->sent_us[i])
+            rtr_rtt_add(req->timing, id, rx_us - req->sent_us[i]);
+        req->pending &= ~(1u << i);
+        return i;
+    }
+    return -1;
+}
+
+void rtr_shared(struct rtr_request *req, uint32_t id) {
+    for (int i = 0; i < req->n; i++)
+        if (req->ids[i] == id)
+            req->shared |= 1u << i;
+}
+
+void rtr_expire(struct rtr_request *req, uint64_t now_us) {
+    for (int i = 0; i < req->n; i++) {
+        if (!(req->pending & (1u << i)) || now_us < req->deadline_us[i])
+            continue;
+
+        if (req->attempts[i] < RTR_ATTEMPTS) {
+            req->timing->retries++;
+            rtr_request_node(req, i, now_us);
+        } else {
+            req->timing->failures++;
+            req->pending &= ~(1u << i);
+            req->failed  |= 1u << i;
+        }
+    }
+}
+
+int rtr_complete(const struct rtr_request *req) {
+    return req->pending == 0;
+}
+
+uint64_t rtr_next_deadline(const struct rtr_request *req) {
+    uint64_t next = UINT64_MAX;
+
+    for (int i = 0; i < req->n; i++)
+        if ((req->pending & (1u << i)) && req->deadline_us[i] < next)
+            next = req->deadline_us[i];
+    return next;
+}
+
+int rtr_remaining_ms(const struct rtr_request *req, uint64_t now_us) {
+    uint64_t next = rtr_next_deadline(req);
+
+    if (next == UINT64_MAX || next <= now_us)
+        return 0;
+    return (int)((next - now_us + 999) / 1000);
+}
+
+// ============ Status Cache ============
+void rtr_cache_init(struct rtr_cache *cache, uint32_t lease_ms) {
+    memset(cache, 0, sizeof(*cache));
+    cache->lease_us = (uint64_t)lease_ms * 1000;
+}
+
+static struct rtr_cache_entry *cache_find(struct rtr_cache *cache, uint32_t id) {
+    for (int i = 0; i < cache->n; i++)
+        if (cache->entries[i].id == id)
+            return &cache->entries[i];
+    return NULL;
+}
+
+void rtr_cache_put(struct rtr_cache *cache, uint32_t id, int status, uint64_t heard_us) {
+    struct rtr_cache_entry *e = cache_find(cache, id);
+
+    if (e == NULL) {
+        if (cache->n == RTR_CACHE_SIZE)
+            return;
+        e = &cache->entries[cache->n++];
+        e->id = id;
+    } else if (heard_us < e->heard_us)
+        return;
+
+    e->status = status;
+    e->heard_us = heard_us;
+}
+
+int rtr_cache_get(struct rtr_cache *cache, uint32_t id, uint64_t now_us, int *status) {
+    struct rtr_cache_entry *e = cache_find(cache, id);
+
+    if (e == NULL || cache->lease_us == 0 ||
+        (now_us > e->heard_us && now_us - e->heard_us >= cache->lease_us)) {
+        cache->misses++;
+        return 0;
+    }
+    *status = e->status;
+    cache->hits++;
+    return 1;
+}
@@ -0,0 +1,124 @@
+#ifndef RTR_H
+#define RTR_H
+
+#include <linux/can.h>
+#include <stdint.h>
+#include "histogram.h"
+
+/*
+ * Parallel remote requests.
+ *
+ * rtr_send() puts one RTR frame per node on the bus back to back; replies
+ * are matched to their node by CAN id in whatever order they arrive. A
+ * batch takes as long as its slowest node, not the sum.
+ *
+ * Each node has its own deadline, derived from its round-trip history
+ * (struct rtr_timing): a high percentile of the observed RTT times a
+ * safety factor, kept between a floor and the ceiling. A node that
+ * misses its deadline is asked once more before it is declared failed;
+ * both attempts together never exceed the ceiling. Until a node has
+ * enough samples each attempt gets an equal share of the ceiling.
+ *
+ * A reply is an RTT sample only if it surely answers our first request:
+ * it arrived after that request went out, the node was not asked again,
+ * and nobody else asked the node meanwhile (rtr_shared), since the reply
+ * might be theirs.
+ *
+ *   rtr_send(&req, fd, ids, 2, dlc, now_us(), &timing);
+ *   while (!rtr_complete(&req)) {
+ *       poll(... rtr_remaining_ms(&req, now_us()) ...);
+ *       if (read(fd, &frame, sizeof(frame)) == sizeof(frame)) {
+ *           int node = rtr_match(&req, &frame, now_us());
+ *           if (node >= 0) status[node] = frame.data[0];
+ *       }
+ *       rtr_expire(&req, now_us());
+ *   }
+ *
+ * struct rtr_cache keeps the last status heard from each node, whether it
+ * answered our request or someone else's. A node whose entry is younger
+ * than the lease does not need to be asked again.
+ */
+
+#define RTR_MAX_NODES  8
+#define RTR_CACHE_SIZE 8
+#define RTR_ATTEMPTS   2        // first request + one retry
+
+// RTT statistics
+#define RTR_RTT_MIN_SAMPLES  8      // fewer than this: ceiling / RTR_ATTEMPTS per attempt
+#define RTR_RTT_WINDOW       256    // counts are halved past this, recent replies dominate
+#define RTR_RTT_PERCENTILE   99
+#define RTR_RTT_FACTOR       4
+
+struct rtr_rtt {
+    uint32_t id;
+    struct histogram hist;
+};
+
+struct rtr_timing {
+    struct rtr_rtt nodes[RTR_CACHE_SIZE];
+    int      n;
+    uint32_t floor_us;      // shortest wait per attempt
+    uint32_t ceiling_us;    // longest wait per node, all attempts together
+    uint64_t retries, failures;
+};
+
+void     rtr_timing_init(struct rtr_timing *t, uint32_t floor_ms, uint32_t ceiling_ms);
+void     rtr_rtt_add(struct rtr_timing *t, uint32_t id, uint64_t rtt_us);
+// Upper bound of the bucket holding the pct-th percentile, 0 if there are too few samples
+uint64_t rtr_rtt_percentile(const struct rtr_timing *t, uint32_t id, int pct);
+// Wait for one attempt
+uint64_t rtr_attempt_timeout_us(const struct rtr_timing *t, uint32_t id);
+
+struct rtr_request {
+    uint32_t ids[RTR_MAX_NODES];
+    int      n;
+    uint32_t pending;       // bit per node still waiting for its reply
+    uint32_t failed;        // bit per node that missed every attempt
+    uint32_t shared;        // bit per node someone else asked too, its reply is no RTT sample
+    uint8_t  attempts[RTR_MAX_NODES];
+    uint64_t sent_us[RTR_MAX_NODES];
+    uint64_t deadline_us[RTR_MAX_NODES];
+    int      fd;
+    uint8_t  dlc;
+    struct rtr_timing *timing;
+};
+
+// Sends every request; returns the number of frames written
+int rtr_send(struct rtr_request *req, int fd, const uint32_t *ids, int n, uint8_t dlc,
+             uint64_t now_us, struct rtr_timing *timing);
+
+// Index of the node this frame answers (and marks it answered), -1 if unrelated or repeated.
+// rx_us is the frame's receive time; it becomes an RTT sample only on the first attempt,
+// if it is not older than the request and the node's request was not shared
+int rtr_match(struct rtr_request *req, const struct can_frame *frame, uint64_t rx_us);
+
+// Another requester asked node id while ours is pending (or its request is still unanswered)
+void rtr_shared(struct rtr_request *req, uint32_t id);
+
+// Retries or fails the nodes whose deadline passed
+void rtr_expire(struct rtr_request *req, uint64_t now_us);
+
+int      rtr_complete(const struct rtr_request *req);
+uint64_t rtr_next_deadline(const struct rtr_request *req);   // UINT64_MAX when complete
+int      rtr_remaining_ms(const struct rtr_request *req, uint64_t now_us);
+
+struct rtr_cache_entry {
+    uint32_t id;
+    int      status;
+    uint64_t heard_us;      // when the frame was received
+};
+
+struct rtr_cache {
+    struct rtr_cache_entry entries[RTR_CACHE_SIZE];
+    int      n;
+    uint64_t lease_us;      // 0 = always ask
+    uint64_t hits, misses;
+};
+
+void rtr_cache_init(struct rtr_cache *cache, uint32_t lease_ms);
+// Older frames never replace newer ones (frames may be read out of order)
+void rtr_cache_put(struct rtr_cache *cache, uint32_t id, int status, uint64_t heard_us);
+// 1 with *status set if the entry is within its lease, else 0
+int  rtr_cache_get(struct rtr_cache *cache, uint32_t id, uint64_t now_us, int *status);
+
+#endif
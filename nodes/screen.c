@@ -0,0 +1,328 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "screen.h"
+
+#define SCREEN_GAP_MAX  4       // unchanged cells rewritten rather than skipped with a cursor move
+
+#define SCREEN_RESET_ATTR   "\e[0m"
+#define SCREEN_RESET_CLEAR  "\e[0m\e[H\e[2J"
+
+static const struct screen_cell blank = {{' '}, 1, 0};
+
+// ============ UTF-8 ============
+static int utf8_len(unsigned char c) {
+    if (c < 0x80)           return 1;
+    if ((c & 0xE0) == 0xC0) return 2;
+    if ((c & 0xF0) == 0xE0) return 3;
+    if ((c & 0xF8) == 0xF0) return 4;
+    return 1;  // stray continuation byte, shown as-is
+}
+
+static uint32_t utf8_decode(const char *s, int len) {
+    const unsigned char *u = (const unsigned char *)s;
+
+    switch (len) {
+        case 2:  return ((u[0] & 0x1F) << 6)  | (u[1] & 0x3F);
+        case 3:  return ((u[0] & 0x0F) << 12) | ((u[1] & 0x3F) << 6) | (u[2] & 0x3F);
+        case 4:  return ((u[0] & 0x07) << 18) | ((u[1] & 0x3F) << 12) | ((u[2] & 0x3F) << 6) | (u[3] & 0x3F);
+        default: return u[0];
+    }
+}
+
+// East Asian Wide / emoji presentation ranges that occupy two columns
+static const uint32_t wide_ranges[][2] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3},
+    {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693},
+    {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F5}, {0x26FA, 0x26FA}, {0x26FD, 0x26FD},
+    {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E},
+    {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0xA4CF}, {0xAC00, 0xD7A3},
+    {0xF900, 0xFAFF}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF},
+    {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x3FFFD},
+};
+
+static int glyph_width(uint32_t cp) {
+    for (size_t i = 0; i < sizeof(wide_ranges) / sizeof(wide_ranges[0]); i++) {
+        if (cp < wide_ranges[i][0])
+            break;
+        if (cp <= wide_ranges[i][1])
+            return 2;
+    }
+    return 1;
+}
+
+// ============ Setup ============
+int screen_init(struct screen *scr, int rows, int cols) {
+    memset(scr, 0, sizeof(*scr));
+    scr->rows  = rows;
+    scr->cols  = cols;
+    scr->back  = malloc(sizeof(struct screen_cell) * rows * cols);
+    scr->front = malloc(sizeof(struct screen_cell) * rows * cols);
+    scr->dirty = malloc(rows);
+    scr->out_cap = (size_t)rows * cols * 16;
+    scr->out   = malloc(scr->out_cap);
+
+    if (!scr->back || !scr->front || !scr->dirty || !scr->out) {
+        perror("screen alloc failed");
+        screen_free(scr);
+        return -1;
+    }
+
+    screen_clear(scr);
+    scr->full = 1;
+    return 0;
+}
+
+void screen_free(struct screen *scr) {
+    free(scr->back);
+    free(scr->front);
+    free(scr->dirty);
+    free(scr->out);
+    scr->back = scr->front = NULL;
+    scr->dirty = NULL;
+    scr->out = NULL;
+}
+
+// ============ Drawing (back buffer) ============
+void screen_clear(struct screen *scr) {
+    for (int i = 0; i < scr->rows * scr->cols; i++)
+        scr->back[i] = blank;
+    memset(scr->dirty, 1, scr->rows);
+    scr->row = scr->col = 0;
+    scr->clip = scr->cols;
+    scr->attr = 0;
+}
+
+void screen_move(struct screen *scr, int row, int col) {
+    scr->row = row;
+    scr->col = col;
+}
+
+void screen_attr(struct screen *scr, uint8_t attr) {
+    scr->attr = attr;
+}
+
+void screen_cursor(struct screen *scr, int row, int col) {
+    scr->cursor_row = row;
+    scr->cursor_col = col;
+}
+
+void screen_invalidate(struct screen *scr) {
+    scr->full = 1;
+}
+
+void screen_box(struct screen *scr, int row, int col, int width) {
+    scr->row  = row;
+    scr->col  = col;
+    scr->clip = (col + width < scr->cols) ? col + width : scr->cols;
+    if (row < 0 || row >= scr->rows)
+        return;
+
+    struct screen_cell *line = &scr->back[row * scr->cols];
+    for (int c = col; c < scr->clip; c++)
+        line[c] = blank;
+    // A wide glyph straddling the right edge loses its other half too
+    if (scr->clip < scr->cols && line[scr->clip].len == 0)
+        line[scr->clip] = blank;
+    scr->dirty[row] = 1;
+}
+
+void screen_unbox(struct screen *scr) {
+    scr->clip = scr->cols;
+}
+
+static void put_glyph(struct screen *scr, const char *g, int len) {
+    int width = glyph_width(utf8_decode(g, len));
+
+    if (scr->row < 0 || scr->row >= scr->rows || scr->col + width > scr->clip) {
+        scr->col += width;  // clipped
+        return;
+    }
+
+    struct screen_cell *line = &scr->back[scr->row * scr->cols];
+    int c = scr->col;
+
+    // Never leave half of a wide glyph behind
+    if (line[c].len == 0 && c > 0)
+        line[c - 1] = blank;
+    if (c + width < scr->cols && line[c + width].len == 0)
+        line[c + width] = blank;
+
+    memcpy(line[c].glyph, g, len);
+    line[c].len  = len;
+    line[c].attr = scr->attr;
+    if (width == 2) {
+        line[c + 1].len  = 0;
+        line[c + 1].attr = scr->attr;
+    }
+    scr->dirty[scr->row] = 1;
+    scr->col += width;
+}
+
+void screen_puts(struct screen *scr, const char *s) {
+    while (*s) {
+        if (*s == '\n') {
+            scr->row++;
+            scr->col = 0;
+            s++;
+            continue;
+        }
+
+        int len = utf8_len((unsigned char)*s);
+        for (int i = 1; i < len; i++)
+            if (s[i] == '\0')
+                return;  // truncated sequence
+
+        put_glyph(scr, s, len);
+        s += len;
+    }
+}
+
+void screen_printf(struct screen *scr, const char *fmt, ...) {
+    char buf[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    screen_puts(scr, buf);
+}
+
+// ============ Diff + Emit ============
+static void emit(struct screen *scr, const char *s, size_t n) {
+    if (scr->out_len + n > scr->out_cap) {
+        size_t cap = scr->out_cap * 2 + n;
+        char *p = realloc(scr->out, cap);
+        // Frame gets truncated while front[] records it as written: repaint it all next time
+        if (p == NULL) {
+            scr->full = 1;
+            return;
+        }
+        scr->out = p;
+        scr->out_cap = cap;
+    }
+    memcpy(scr->out + scr->out_len, s, n);
+    scr->out_len += n;
+}
+
+static void emit_move(struct screen *scr, int row, int col) {
+    char seq[24];
+    int n = snprintf(seq, sizeof(seq), "\e[%d;%dH", row + 1, col + 1);
+    emit(scr, seq, n);
+}
+
+static void emit_attr(struct screen *scr, uint8_t attr) {
+    char seq[24];
+    int n = snprintf(seq, sizeof(seq), "\e[0%s%s%s", (attr & SCR_BOLD) ? ";1" : "", (attr & SCR_DIM) ? ";2" : "",
+                     (attr & SCR_BLINK) ? ";5" : "");
+
+    if (attr & SCR_COLOR)
+        n += snprintf(seq + n, sizeof(seq) - n, ";3%d", attr & 0x07);
+    seq[n++] = 'm';
+    emit(scr, seq, n);
+}
+
+static int cell_eq(const struct screen_cell *a, const struct screen_cell *b) {
+    return a->len == b->len && a->attr == b->attr && memcmp(a->glyph, b->glyph, a->len) == 0;
+}
+
+long screen_flush(struct screen *scr, int fd) {
+    int cur_row = -1, cur_col = -1;
+    uint8_t cur_attr = 0;  // every flush ends with attributes reset
+    int changed = 0;
+
+    scr->out_len = 0;
+    if (scr->full) {
+        emit(scr, SCREEN_RESET_CLEAR, sizeof(SCREEN_RESET_CLEAR) - 1);
+        for (int i = 0; i < scr->rows * scr->cols; i++)
+            scr->front[i] = blank;
+        memset(scr->dirty, 1, scr->rows);
+        cur_row = cur_col = 0;
+        scr->full = 0;
+        changed = 1;
+    }
+
+    for (int r = 0; r < scr->rows; r++) {
+        struct screen_cell *back  = &scr->back[r * scr->cols];
+        struct screen_cell *front = &scr->front[r * scr->cols];
+        int c = 0;
+
+        // Rows nobody drew on still match the terminal
+        if (!scr->dirty[r])
+            continue;
+        scr->dirty[r] = 0;
+
+        while (c < scr->cols) {
+            if (cell_eq(&back[c], &front[c])) {
+                c++;
+                continue;
+            }
+
+            // Start of a changed run; a wide glyph is always redrawn from its left half
+            if (back[c].len == 0 && c > 0)
+                c--;
+            if (cur_row != r || cur_col != c)
+                emit_move(scr, r, c);
+            cur_row = r;
+            cur_col = c;
+            changed = 1;
+
+            while (c < scr->cols) {
+                if (cell_eq(&back[c], &front[c])) {
+                    // Bridge short unchanged gaps instead of moving the cursor
+                    int next = c;
+                    while (next < scr->cols && next - c < SCREEN_GAP_MAX && cell_eq(&back[next], &front[next]))
+                        next++;
+                    if (next == scr->cols || next - c >= SCREEN_GAP_MAX)
+                        break;
+                }
+
+                if (back[c].len == 0) {  // right half, already covered
+                    front[c] = back[c];
+                    c++;
+                    continue;
+                }
+
+                if (back[c].attr != cur_attr) {
+                    emit_attr(scr, back[c].attr);
+                    cur_attr = back[c].attr;
+                }
+                emit(scr, back[c].glyph, back[c].len);
+
+                int width = (c + 1 < scr->cols && back[c + 1].len == 0) ? 2 : 1;
+                for (int i = 0; i < width; i++)
+                    front[c + i] = back[c + i];
+                c       += width;
+                cur_col += width;
+            }
+        }
+    }
+
+    if (!changed && scr->cursor_row == scr->term_row && scr->cursor_col == scr->term_col)
+        return 0;
+
+    if (cur_attr != 0)
+        emit(scr, SCREEN_RESET_ATTR, sizeof(SCREEN_RESET_ATTR) - 1);
+    emit_move(scr, scr->cursor_row, scr->cursor_col);
+    scr->term_row = scr->cursor_row;
+    scr->term_col = scr->cursor_col;
+
+    size_t done = 0;
+    while (done < scr->out_len) {
+        ssize_t n = write(fd, scr->out + done, scr->out_len - done);
+        if (n < 0) {
+            perror("screen write failed");
+            scr->full = 1;
+            return -1;
+        }
+        done += n;
+    }
+
+    scr->frames++;
+    scr->bytes += scr->out_len;
+    return (long)scr->out_len;
+}
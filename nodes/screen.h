@@ -0,0 +1,86 @@
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Terminal screen model.
+ *
+ * Drawing goes into a back buffer of cells (UTF-8 glyph + attribute).
+ * screen_flush() diffs it against the front buffer (what the terminal
+ * shows), emits cursor moves, attribute changes and glyphs for the changed
+ * runs only, and hands the result to the terminal in a single write().
+ * Only rows drawn on since the last flush are compared, so redrawing a
+ * few boxes (screen_box) costs those rows, not the whole screen.
+ *
+ *   screen_clear(&scr);
+ *   screen_move(&scr, 0, 0);
+ *   screen_attr(&scr, SCR_BOLD | SCR_RED);
+ *   screen_printf(&scr, "Door: %s\n", "Open");
+ *   screen_flush(&scr, STDOUT_FILENO);
+ */
+
+// Attributes: one foreground colour + bold + blink + dim
+#define SCR_COLOR     0x08      // set when a foreground colour is selected
+#define SCR_RED       (SCR_COLOR | 1)
+#define SCR_GREEN     (SCR_COLOR | 2)
+#define SCR_YELLOW    (SCR_COLOR | 3)
+#define SCR_WHITE     (SCR_COLOR | 7)
+#define SCR_BOLD      0x10
+#define SCR_BLINK     0x20
+#define SCR_DIM       0x40      // faint, for values that are no longer current
+
+struct screen_cell {
+    char    glyph[4];           // UTF-8, not terminated; len 0 = right half of a wide glyph
+    uint8_t len;
+    uint8_t attr;
+};
+
+struct screen {
+    int rows, cols;
+    struct screen_cell *back;   // being drawn
+    struct screen_cell *front;  // on the terminal
+    uint8_t *dirty;             // per row: drawn on since the last flush
+    int full;                   // next flush repaints everything
+
+    // Pen for screen_printf(), clipped at column clip
+    int row, col;
+    int clip;
+    uint8_t attr;
+
+    // Where the terminal cursor is left after a flush (e.g. the input prompt)
+    int cursor_row, cursor_col;
+    int term_row, term_col;     // where the last flush left it
+
+    // Frame being emitted
+    char *out;
+    size_t out_len, out_cap;
+
+    // Totals, for comparing against a full repaint
+    uint64_t frames;
+    uint64_t bytes;
+};
+
+int  screen_init(struct screen *scr, int rows, int cols);
+void screen_free(struct screen *scr);
+
+void screen_clear(struct screen *scr);
+void screen_move(struct screen *scr, int row, int col);
+void screen_attr(struct screen *scr, uint8_t attr);
+void screen_puts(struct screen *scr, const char *s);    // '\n' goes to the next row
+void screen_printf(struct screen *scr, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void screen_cursor(struct screen *scr, int row, int col);
+
+// Blanks width cells at (row, col), moves the pen there and clips drawing to them
+// until screen_unbox() or screen_clear()
+void screen_box(struct screen *scr, int row, int col, int width);
+void screen_unbox(struct screen *scr);
+
+// The terminal was written behind the model's back: repaint everything next time
+void screen_invalidate(struct screen *scr);
+
+// Returns the bytes written for this frame (0 if nothing changed), -1 on error
+long screen_flush(struct screen *scr, int fd);
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef SECOC_H
+#define SECOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "aes/esp_aes.h"
+#endif
+
+/*
+ * Authenticated frames (SecOC-style).
+ *
+ * A secured frame carries the payload, the full 32-bit freshness value
+ * (big-endian) and an AES-128-CMAC truncated to 24 bits:
+ *
+ *   data[0 .. len-1]      payload
+ *   data[len .. len+3]    freshness value, strictly increasing per sender
+ *   data[len+4 .. len+6]  CMAC over the 16-bit data id (CAN id) + payload + freshness
+ *
+ * A MAC input never exceeds one AES block, so one block encryption per frame.
+ * Key schedule and CMAC subkeys are computed once by secoc_key_init(). The
+ * block cipher is AES-NI on x86 hosts that have it, the AES accelerator on
+ * the ESP32, portable C otherwise.
+ *
+ * Senders start their freshness from secoc_boot_freshness() so a restart
+ * never reuses values; receivers keep the last accepted value and reject
+ * anything not newer. A receiver keeps that value across restarts with
+ * secoc_rx_restore()/secoc_rx_persist(), in blocks so storage is written
+ * once every SECOC_PERSIST_BLOCK frames: the stored value is a reservation
+ * ahead of the last accepted one and becomes the floor after a restart.
+ * The cost is that a sender still inside the reserved block has up to that
+ * many frames rejected after the receiver restarts.
+ *
+ * Keys are provisioned per vehicle and never built in. The dashboard reads
+ * 32 hex digits from the file given with -k; an ESP32 node reads the
+ * 16-byte blob "key" in NVS namespace "secoc", written at end of line with
+ * the NVS partition generator:
+ *
+ *   key,type,encoding,value
+ *   secoc,namespace,,
+ *   key,data,hex2bin,<32 hex digits>
+ */
+
+#define SECOC_KEY_LEN   16
+#define SECOC_FV_LEN    4
+#define SECOC_MAC_LEN   3
+#define SECOC_OVERHEAD  (SECOC_FV_LEN + SECOC_MAC_LEN)
+#define SECOC_PERSIST_BLOCK  16     // accepted frames per storage write
+
+// secoc_verify() errors (>= 0 is the payload length)
+#define SECOC_ERR_LENGTH -1  // frame too short to be secured
+#define SECOC_ERR_MAC    -2  // wrong key or tampered
+#define SECOC_ERR_FRESH  -3  // freshness not newer than the last accepted (replay)
+
+struct secoc_key {
+#ifdef ESP_PLATFORM
+    esp_aes_context aes;
+#else
+    uint8_t round_keys[176];
+#endif
+    uint8_t k1[16];          // CMAC subkey for a complete final block
+    uint8_t k2[16];          // CMAC subkey for a padded final block
+};
+
+struct secoc_tx_state {
+    uint32_t freshness;      // last value sent
+};
+
+struct secoc_rx_state {
+    uint32_t freshness;      // last value accepted
+    uint32_t reserved;       // stored floor; stored again once freshness reaches it
+};
+
+int  secoc_key_init(struct secoc_key *key, const uint8_t raw[SECOC_KEY_LEN]);
+void secoc_key_free(struct secoc_key *key);
+int  secoc_key_parse(const char *hex, uint8_t raw[SECOC_KEY_LEN]);  // 32 hex digits
+// Provisioned key (ESP32 NVS); -1 if there is none or on Linux
+int  secoc_key_load(uint8_t raw[SECOC_KEY_LEN]);
+
+// IDs whose frames are secured when a key is configured
+int secoc_authenticated(uint32_t can_id);
+
+// Returns the secured frame length (new DLC), or -1 if it does not fit
+int secoc_protect(const struct secoc_key *key, struct secoc_tx_state *tx,
+                  uint32_t can_id, uint8_t data[8], uint8_t data_len);
+int secoc_verify(const struct secoc_key *key, struct secoc_rx_state *rx,
+                 uint32_t can_id, const uint8_t *data, uint8_t dlc);
+const char *secoc_strerror(int err);
+
+// Full (untruncated) CMAC, message of at most 16 bytes
+void secoc_cmac(const struct secoc_key *key, const uint8_t *msg, size_t len, uint8_t mac[16]);
+
+// Freshness starting point that is larger than anything sent before a restart:
+// NVS reset counter << 16 on the ESP32, wall-clock seconds on Linux
+uint32_t secoc_boot_freshness(void);
+
+// Non-volatile freshness storage: ESP32 NVS, or on Linux the file <prefix>.<name>
+// once secoc_persist_init() named a prefix; -1 where unavailable
+void secoc_persist_init(const char *prefix);
+int secoc_persist_load(const char *name, uint32_t *value);
+int secoc_persist_store(const char *name, uint32_t value);
+
+// Receiver floor from storage; -1 if none was stored
+int secoc_rx_restore(struct secoc_rx_state *rx, const char *name);
+// After an accepted frame, before acting on it: reserves the next block once the
+// stored one is used up. -1 if that write failed (the frame must not be trusted
+// across a restart)
+int secoc_rx_persist(struct secoc_rx_state *rx, const char *name);
+
+// Block cipher selection: "aes-ni", "esp32-hw" or "software"
+const char *secoc_aes_impl(void);
+int secoc_force_software(int enable);   // benchmarking; -1 where the choice is fixed
+
+// Time per frame in ns for protect (sender) and verify (receiver)
+void secoc_benchmark(const struct secoc_key *key, uint32_t iterations, uint64_t (*now_us)(void),
+                     double *protect_ns, double *verify_ns);
+
+#endif
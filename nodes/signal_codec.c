@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <string.h>
+#include "signal_codec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIGNAL_HAVE_AVX2 1
+#endif
+
+// ============ Scalar Codec ============
+static inline uint64_t load_word(const uint8_t *p, int byte_order) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return (byte_order == SIG_BIG_ENDIAN) ? __builtin_bswap64(w) : w;
+#else
+    return (byte_order == SIG_BIG_ENDIAN) ? w : __builtin_bswap64(w);
+#endif
+}
+
+static inline void store_word(uint8_t *p, uint64_t w, int byte_order) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (byte_order == SIG_BIG_ENDIAN) w = __builtin_bswap64(w);
+#else
+    if (byte_order != SIG_BIG_ENDIAN) w = __builtin_bswap64(w);
+#endif
+    memcpy(p, &w, sizeof(w));
+}
+
+static inline uint64_t field_mask(uint8_t length) {
+    return (length >= 64) ? ~0ULL : ((1ULL << length) - 1);
+}
+
+int64_t signal_extract_raw(const struct can_signal *sig, const uint8_t data[8]) {
+    uint64_t raw = (load_word(data, sig->byte_order) >> sig->start_bit) & field_mask(sig->length);
+
+    if (sig->is_signed && sig->length < 64) {
+        uint64_t sign = 1ULL << (sig->length - 1);
+        raw = (raw ^ sign) - sign;
+    }
+    return (int64_t)raw;
+}
+
+double signal_decode(const struct can_signal *sig, const uint8_t data[8]) {
+    int64_t raw = signal_extract_raw(sig, data);
+
+    if (!sig->is_signed)
+        return (double)(uint64_t)raw * sig->factor + sig->offset;
+    return (double)raw * sig->factor + sig->offset;
+}
+
+void signal_insert_raw(const struct can_signal *sig, uint8_t data[8], int64_t raw) {
+    uint64_t mask = field_mask(sig->length) << sig->start_bit;
+    uint64_t w    = load_word(data, sig->byte_order);
+
+    w = (w & ~mask) | (((uint64_t)raw << sig->start_bit) & mask);
+    store_word(data, w, sig->byte_order);
+}
+
+int64_t signal_raw_from_phys(const struct can_signal *sig, double physical) {
+    double raw = (physical - sig->offset) / sig->factor;
+    return (int64_t)(raw < 0 ? raw - 0.5 : raw + 0.5);
+}
+
+void signal_encode(const struct can_signal *sig, uint8_t data[8], double physical) {
+    signal_insert_raw(sig, data, signal_raw_from_phys(sig, physical));
+}
+
+// ============ Fixed-Point Format ============
+void signal_fixed_format(const struct can_signal *sig, uint8_t decimals, struct fixed_format *fmt) {
+    double scale = sig->factor, bias = sig->offset;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10.0;
+        bias  *= 10.0;
+    }
+
+    // Largest shift that keeps |mul| below 2^31, so 32-bit raw values never overflow
+    double mag = (scale < 0) ? -scale : scale;
+    uint8_t shift = 0;
+    while (shift < 62 && mag * (double)(1ULL << (shift + 1)) < 2147483648.0)
+        shift++;
+
+    double mul = scale * (double)(1ULL << shift);
+    fmt->mul      = (int64_t)(mul < 0 ? mul - 0.5 : mul + 0.5);
+    fmt->bias     = (int64_t)(bias < 0 ? bias - 0.5 : bias + 0.5);
+    fmt->shift    = shift;
+    fmt->decimals = decimals;
+}
+
+int fixed_to_str(char *buf, size_t size, int64_t value, uint8_t decimals) {
+    int64_t div = 1;
+    for (uint8_t i = 0; i < decimals; i++)
+        div *= 10;
+
+    const char *sign = (value < 0) ? "-" : "";
+    uint64_t mag = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+
+    if (decimals == 0)
+        return snprintf(buf, size, "%s%llu", sign, (unsigned long long)mag);
+    return snprintf(buf, size, "%s%llu.%0*llu", sign, (unsigned long long)(mag / div),
+                    decimals, (unsigned long long)(mag % div));
+}
+
+void signal_decode_batch_scalar(const struct can_signal *sig, const uint8_t *payloads,
+                                size_t count, double *out) {
+    for (size_t i = 0; i < count; i++)
+        out[i] = signal_decode(sig, payloads + i * 8);
+}
+
+// ============ Multiplexed Messages ============
+int can_mux_init(struct can_mux_message *msg) {
+    if (msg->selector.length == 0 || msg->selector.length > 8)
+        return -1;
+
+    for (int i = 0; i < 256; i++)
+        msg->dispatch[i] = -1;
+
+    for (size_t i = 0; i < msg->page_count; i++) {
+        uint8_t sel = msg->pages[i].selector;
+        if (msg->dispatch[sel] != -1 || sel > field_mask(msg->selector.length))
+            return -1;
+        msg->dispatch[sel] = (int16_t)i;
+    }
+    return 0;
+}
+
+const struct can_mux_page *can_mux_decode(const struct can_mux_message *msg, const uint8_t data[8]) {
+    int16_t page = msg->dispatch[(uint8_t)signal_extract_raw(&msg->selector, data)];
+    return (page < 0) ? NULL : &msg->pages[page];
+}
+
+// raw_values holds one value per signal of the selected page, in page order
+int can_mux_encode(const struct can_mux_message *msg, uint8_t selector,
+                   const int64_t *raw_values, uint8_t data[8]) {
+    int16_t idx = msg->dispatch[selector];
+    if (idx < 0)
+        return -1;
+
+    const struct can_mux_page *page = &msg->pages[idx];
+    memset(data, 0, 8);
+    signal_insert_raw(&msg->selector, data, selector);
+    for (size_t i = 0; i < page->count; i++)
+        signal_insert_raw(&page->signals[i], data, raw_values[i]);
+    return 0;
+}
+
+// Page that carries sig, or NULL for a plain signal
+const struct can_mux_page *can_mux_page_of(const struct can_mux_message *msg, const struct can_signal *sig) {
+    for (size_t p = 0; p < msg->page_count; p++)
+        if (sig >= msg->pages[p].signals && sig < msg->pages[p].signals + msg->pages[p].count)
+            return &msg->pages[p];
+    return NULL;
+}
+
+// ============ Page Schedule ============
+void can_mux_schedule_init(struct can_mux_schedule *s, const struct can_mux_message *msg, uint64_t now_ms) {
+    memset(s, 0, sizeof(*s));
+    s->msg = msg;
+    for (size_t i = 0; i < msg->page_count && i < 256; i++) {
+        s->period_ms[i]   = msg->pages[i].period_ms;
+        s->next_due_ms[i] = now_ms;
+    }
+}
+
+// Returns the index of the next due page (rotating among ties), or -1
+int can_mux_schedule_next(struct can_mux_schedule *s, uint64_t now_ms) {
+    size_t n = s->msg->page_count;
+
+    for (size_t k = 0; k < n; k++) {
+        size_t i = (s->cursor + k) % n;
+        if (s->period_ms[i] == 0 || s->next_due_ms[i] > now_ms)
+            continue;
+
+        s->next_due_ms[i] += s->period_ms[i];
+        if (s->next_due_ms[i] <= now_ms)         // fell behind, don't burst
+            s->next_due_ms[i] = now_ms + s->period_ms[i];
+        s->cursor = i + 1;
+        return (int)i;
+    }
+    return -1;
+}
+
+uint32_t can_mux_schedule_wait_ms(const struct can_mux_schedule *s, uint64_t now_ms) {
+    uint64_t next = UINT64_MAX;
+
+    for (size_t i = 0; i < s->msg->page_count; i++)
+        if (s->period_ms[i] != 0 && s->next_due_ms[i] < next)
+            next = s->next_due_ms[i];
+
+    if (next == UINT64_MAX)
+        return 1000;
+    return (next <= now_ms) ? 0 : (uint32_t)(next - now_ms);
+}
+
+// ============ AVX2 Batch Codec ============
+#ifdef SIGNAL_HAVE_AVX2
+/*
+ * Four payloads per 256-bit register: byte swap (for big-endian), shift,
+ * mask and sign-extend in 64-bit lanes, then convert to double with the
+ * 1.5 * 2^52 magic constant, which is exact for |raw| < 2^51.
+ */
+__attribute__((target("avx2")))
+static void signal_decode_batch_avx2(const struct can_signal *sig, const uint8_t *payloads,
+                                     size_t count, double *out) {
+    const __m256i bswap = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                           7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    const __m256i ident = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                           0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i order   = (sig->byte_order == SIG_BIG_ENDIAN) ? bswap : ident;
+    const __m128i shift   = _mm_cvtsi32_si128(sig->start_bit);
+    const __m256i mask    = _mm256_set1_epi64x((long long)field_mask(sig->length));
+    const __m256i sign    = _mm256_set1_epi64x(sig->is_signed ? (long long)(1ULL << (sig->length - 1)) : 0);
+    const __m256i magic_i = _mm256_set1_epi64x(0x4338000000000000LL);
+    const __m256d magic_d = _mm256_set1_pd(6755399441055744.0);
+    const __m256d factor  = _mm256_set1_pd(sig->factor);
+    const __m256d offset  = _mm256_set1_pd(sig->offset);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(payloads + i * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(payloads + i * 8 + 32));
+
+        a = _mm256_and_si256(_mm256_srl_epi64(_mm256_shuffle_epi8(a, order), shift), mask);
+        b = _mm256_and_si256(_mm256_srl_epi64(_mm256_shuffle_epi8(b, order), shift), mask);
+        a = _mm256_sub_epi64(_mm256_xor_si256(a, sign), sign);
+        b = _mm256_sub_epi64(_mm256_xor_si256(b, sign), sign);
+
+        __m256d va = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(a, magic_i)), magic_d);
+        __m256d vb = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(b, magic_i)), magic_d);
+        _mm256_storeu_pd(out + i,     _mm256_add_pd(_mm256_mul_pd(va, factor), offset));
+        _mm256_storeu_pd(out + i + 4, _mm256_add_pd(_mm256_mul_pd(vb, factor), offset));
+    }
+
+    signal_decode_batch_scalar(sig, payloads + i * 8, count - i, out + i);
+}
+#endif
+
+static int use_avx2(void) {
+#ifdef SIGNAL_HAVE_AVX2
+    static int cached = -1;
+    if (cached < 0)
+        cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+    return cached;
+#else
+    return 0;
+#endif
+}
+
+// The magic constant conversion is exact up to 51 bits; wider fields stay scalar
+static int batch_avx2(const struct can_signal *sig) {
+    return sig->length <= 51 && use_avx2();
+}
+
+void signal_decode_batch(const struct can_signal *sig, const uint8_t *payloads,
+                         size_t count, double *out) {
+#ifdef SIGNAL_HAVE_AVX2
+    if (batch_avx2(sig)) {
+        signal_decode_batch_avx2(sig, payloads, count, out);
+        return;
+    }
+#endif
+    signal_decode_batch_scalar(sig, payloads, count, out);
+}
+
+const char *signal_batch_impl(const struct can_signal *sig) {
+    return batch_avx2(sig) ? "avx2" : "scalar";
+}
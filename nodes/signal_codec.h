@@ -0,0 +1,109 @@
+#ifndef SIGNAL_CODEC_H
+#define SIGNAL_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte order of a signal inside the 8-byte payload
+#define SIG_LITTLE_ENDIAN 0  // Intel: data[0] is the least significant byte
+#define SIG_BIG_ENDIAN    1  // Motorola: data[0] is the most significant byte
+
+/*
+ * A signal is a bit field of the 64-bit word formed by the payload in the
+ * signal's byte order. start_bit is the position of the field's LSB in that
+ * word, so a big-endian 32-bit value in data[0..3] is start_bit 32, length 32.
+ *
+ *   physical = raw * factor + offset
+ */
+struct can_signal {
+    const char *name;
+    uint32_t    can_id;
+    uint8_t     start_bit;
+    uint8_t     length;      // 1..64 bits
+    uint8_t     byte_order;  // SIG_LITTLE_ENDIAN / SIG_BIG_ENDIAN
+    uint8_t     is_signed;
+    double      factor;
+    double      offset;
+};
+
+/*
+ * Fixed-point view of a signal for rendering and export without floats:
+ *   value = ((raw * mul + round) >> shift) + bias
+ * is the physical value in units of 10^-decimals (e.g. 0.1 °C).
+ */
+struct fixed_format {
+    int64_t mul;
+    int64_t bias;
+    uint8_t shift;
+    uint8_t decimals;
+};
+
+/*
+ * Multiplexed message: the selector field picks which page (signal layout)
+ * the rest of the payload carries. dispatch[] maps every selector value
+ * straight to its page, so decode never scans the page list.
+ */
+struct can_mux_page {
+    uint8_t selector;
+    uint32_t period_ms;                // default transmit period of this page
+    const struct can_signal *signals;
+    size_t count;
+};
+
+struct can_mux_message {
+    uint32_t can_id;
+    struct can_signal selector;        // at most 8 bits
+    const struct can_mux_page *pages;
+    size_t page_count;
+    int16_t dispatch[256];             // selector -> page index, -1 if unused
+};
+
+// Round-robin page schedule for a transmitting node
+struct can_mux_schedule {
+    const struct can_mux_message *msg;
+    uint32_t period_ms[256];           // per page index, 0 disables the page
+    uint64_t next_due_ms[256];
+    size_t cursor;
+};
+
+// Signal definitions live in the signal database (signal_db.h, signals.db)
+const struct can_mux_page *can_mux_page_of(const struct can_mux_message *msg, const struct can_signal *sig);
+
+// Single frame
+int64_t signal_extract_raw(const struct can_signal *sig, const uint8_t data[8]);
+double  signal_decode(const struct can_signal *sig, const uint8_t data[8]);
+void    signal_insert_raw(const struct can_signal *sig, uint8_t data[8], int64_t raw);
+int64_t signal_raw_from_phys(const struct can_signal *sig, double physical);
+void    signal_encode(const struct can_signal *sig, uint8_t data[8], double physical);
+
+// Fixed-point format (computed once, used on the render/export path)
+void signal_fixed_format(const struct can_signal *sig, uint8_t decimals, struct fixed_format *fmt);
+int  fixed_to_str(char *buf, size_t size, int64_t value, uint8_t decimals);
+
+static inline int64_t fixed_from_raw(const struct fixed_format *fmt, int64_t raw) {
+    int64_t round = fmt->shift ? (1LL << (fmt->shift - 1)) : 0;
+    return ((raw * fmt->mul + round) >> fmt->shift) + fmt->bias;
+}
+
+// Multiplexed messages
+int  can_mux_init(struct can_mux_message *msg);
+const struct can_mux_page *can_mux_decode(const struct can_mux_message *msg, const uint8_t data[8]);
+int  can_mux_encode(const struct can_mux_message *msg, uint8_t selector,
+                    const int64_t *raw_values, uint8_t data[8]);
+
+void can_mux_schedule_init(struct can_mux_schedule *s, const struct can_mux_message *msg, uint64_t now_ms);
+int  can_mux_schedule_next(struct can_mux_schedule *s, uint64_t now_ms);
+uint32_t can_mux_schedule_wait_ms(const struct can_mux_schedule *s, uint64_t now_ms);
+
+/*
+ * Batch decode: payloads is a column of count 8-byte payloads, out receives
+ * count physical values. Uses AVX2 when the CPU has it and the signal is at
+ * most 51 bits long, scalar otherwise; signal_batch_impl names the path sig takes.
+ */
+void signal_decode_batch(const struct can_signal *sig, const uint8_t *payloads,
+                         size_t count, double *out);
+void signal_decode_batch_scalar(const struct can_signal *sig, const uint8_t *payloads,
+                                size_t count, double *out);
+const char *signal_batch_impl(const struct can_signal *sig);
+
+#endif
@@ -0,0 +1,939 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "signal_db.h"
+#include "signal_filter.h"
+
+#define SDB_MAX_TOKENS    16
+#define SDB_MAX_DECIMALS  9     // fixed_to_str divides by 10^decimals in an int64
+
+// ============ Default Database ============
+// Used when no database file is given: signals.db, turned into a string at build time
+const char signal_db_default_text[] =
+#include "signals_db.inc"
+    ;
+
+// ============ Text Parser ============
+struct sdb_builder {
+    struct sdb_signal *signals;
+    struct sdb_page *pages;
+    struct sdb_mux *muxes;
+    struct sdb_message *messages;
+    char *strings;
+    size_t n_signals, n_pages, n_muxes, n_messages, strings_size;
+    size_t cap_signals, cap_pages, cap_muxes, cap_messages, cap_strings;
+};
+
+static int grow(void **arr, size_t *cap, size_t need, size_t elem) {
+    if (need <= *cap)
+        return 0;
+    size_t n = *cap ? *cap * 2 : 16;
+    while (n < need) n *= 2;
+    void *p = realloc(*arr, n * elem);
+    if (!p)
+        return -1;
+    *arr = p;
+    *cap = n;
+    return 0;
+}
+
+static int add_string(struct sdb_builder *b, const char *s, uint32_t *off) {
+    size_t len = strlen(s) + 1;
+    if (grow((void **)&b->strings, &b->cap_strings, b->strings_size + len, 1) < 0)
+        return -1;
+    memcpy(b->strings + b->strings_size, s, len);
+    *off = (uint32_t)b->strings_size;
+    b->strings_size += len;
+    return 0;
+}
+
+static int parse_order(const char *s, uint8_t *order) {
+    if (strcmp(s, "le") == 0) { *order = SIG_LITTLE_ENDIAN; return 0; }
+    if (strcmp(s, "be") == 0) { *order = SIG_BIG_ENDIAN;    return 0; }
+    return -1;
+}
+
+static int parse_uint(const char *s, unsigned long max, unsigned long *out) {
+    char *end;
+    errno = 0;
+    *out = strtoul(s, &end, 0);
+    return (errno || *end || *out > max) ? -1 : 0;
+}
+
+static int parse_double(const char *s, double *out) {
+    char *end;
+    *out = strtod(s, &end);
+    return (*end || end == s) ? -1 : 0;
+}
+
+static int find_mux(const struct sdb_builder *b, uint32_t can_id) {
+    for (size_t i = 0; i < b->n_muxes; i++)
+        if (b->muxes[i].can_id == can_id)
+            return (int)i;
+    return -1;
+}
+
+// sig <name> <id> <start> <len> <le|be> <u|s> <factor> <offset> [unit= dec= deadband= lo= hi= filter=]
+static int parse_sig(struct sdb_builder *b, char **tok, int n, const int16_t *last_page) {
+    struct sdb_signal s;
+    unsigned long v;
+
+    if (n < 9)
+        return -1;
+    memset(&s, 0, sizeof(s));
+    s.page    = -1;
+    s.warn_lo = NAN;
+    s.warn_hi = NAN;
+
+    if (parse_uint(tok[2], SDB_MAX_ID - 1, &v) < 0) return -1;
+    s.can_id = v;
+    if (parse_uint(tok[3], 63, &v) < 0) return -1;
+    s.start_bit = v;
+    if (parse_uint(tok[4], 64, &v) < 0 || v == 0 || s.start_bit + v > 64) return -1;
+    s.length = v;
+    if (parse_order(tok[5], &s.byte_order) < 0) return -1;
+    if (strcmp(tok[6], "s") != 0 && strcmp(tok[6], "u") != 0) return -1;
+    s.is_signed = (tok[6][0] == 's');
+    if (parse_double(tok[7], &s.factor) < 0 || s.factor == 0) return -1;
+    if (parse_double(tok[8], &s.offset) < 0) return -1;
+
+    const char *unit = "";
+    for (int i = 9; i < n; i++) {
+        char *val = strchr(tok[i], '=');
+        if (!val)
+            return -1;
+        *val++ = '\0';
+
+        if (strcmp(tok[i], "unit") == 0)
+            unit = val;
+        else if (strcmp(tok[i], "dec") == 0) {
+            if (parse_uint(val, SDB_MAX_DECIMALS, &v) < 0) return -1;
+            s.decimals = v;
+        } else if (strcmp(tok[i], "deadband") == 0) {
+            if (parse_uint(val, INT32_MAX, &v) < 0) return -1;
+            s.deadband = v;
+        } else if (strcmp(tok[i], "filter") == 0) {
+            struct filter_spec f;
+            if (filter_parse(val, &f) < 0) return -1;
+            s.filter       = f.kind;
+            s.filter_param = f.param;
+        } else if (strcmp(tok[i], "lo") == 0) {
+            if (parse_double(val, &s.warn_lo) < 0) return -1;
+        } else if (strcmp(tok[i], "hi") == 0) {
+            if (parse_double(val, &s.warn_hi) < 0) return -1;
+        } else
+            return -1;
+    }
+
+    // Signals of a multiplexed id belong to the page declared last for it
+    int mux = find_mux(b, s.can_id);
+    if (mux >= 0) {
+        if (last_page[mux] < 0)
+            return -1;
+        s.page = last_page[mux];
+    }
+
+    if (grow((void **)&b->signals, &b->cap_signals, b->n_signals + 1, sizeof(s)) < 0 ||
+        add_string(b, tok[1], &s.name_off) < 0 || add_string(b, unit, &s.unit_off) < 0)
+        return -1;
+    b->signals[b->n_signals++] = s;
+    return 0;
+}
+
+// mux <id> <start> <len> <le|be>
+static int parse_mux(struct sdb_builder *b, char **tok, int n) {
+    struct sdb_mux m;
+    unsigned long v;
+
+    if (n != 5)
+        return -1;
+    memset(&m, 0, sizeof(m));
+    if (parse_uint(tok[1], SDB_MAX_ID - 1, &v) < 0 || find_mux(b, v) >= 0) return -1;
+    m.can_id = v;
+    if (parse_uint(tok[2], 63, &v) < 0) return -1;
+    m.start_bit = v;
+    if (parse_uint(tok[3], 8, &v) < 0 || v == 0 || m.start_bit + v > 64) return -1;
+    m.length = v;
+    if (parse_order(tok[4], &m.byte_order) < 0) return -1;
+
+    if (grow((void **)&b->muxes, &b->cap_muxes, b->n_muxes + 1, sizeof(m)) < 0)
+        return -1;
+    b->muxes[b->n_muxes++] = m;
+    return 0;
+}
+
+// [period=MS] [timeout=MS]; a period alone is monitored at SDB_TIMEOUT_PERIODS periods
+static int parse_timing(char **tok, int n, uint32_t *period_ms, uint32_t *timeout_ms) {
+    unsigned long v;
+
+    *period_ms = *timeout_ms = 0;
+    for (int i = 0; i < n; i++) {
+        if (strncmp(tok[i], "period=", 7) == 0 && parse_uint(tok[i] + 7, UINT32_MAX / SDB_TIMEOUT_PERIODS, &v) == 0)
+            *period_ms = v;
+        else if (strncmp(tok[i], "timeout=", 8) == 0 && parse_uint(tok[i] + 8, UINT32_MAX, &v) == 0)
+            *timeout_ms = v;
+        else
+            return -1;
+    }
+    if (*timeout_ms == 0)
+        *timeout_ms = *period_ms * SDB_TIMEOUT_PERIODS;
+    return 0;
+}
+
+// msg <id> [period=MS] [timeout=MS]
+static int parse_msg(struct sdb_builder *b, char **tok, int n) {
+    struct sdb_message m;
+    unsigned long v;
+
+    if (n < 3)
+        return -1;
+    memset(&m, 0, sizeof(m));
+    if (parse_uint(tok[1], SDB_MAX_ID - 1, &v) < 0) return -1;
+    m.can_id = v;
+    if (parse_timing(tok + 2, n - 2, &m.period_ms, &m.timeout_ms) < 0) return -1;
+
+    for (size_t i = 0; i < b->n_messages; i++)
+        if (b->messages[i].can_id == m.can_id)
+            return -1;
+    if (grow((void **)&b->messages, &b->cap_messages, b->n_messages + 1, sizeof(m)) < 0)
+        return -1;
+    b->messages[b->n_messages++] = m;
+    return 0;
+}
+
+// page <id> <selector> [period=MS] [timeout=MS]
+static int parse_page(struct sdb_builder *b, char **tok, int n, int16_t *last_page) {
+    struct sdb_page p;
+    unsigned long v;
+
+    if (n < 3)
+        return -1;
+    memset(&p, 0, sizeof(p));
+    if (parse_uint(tok[1], SDB_MAX_ID - 1, &v) < 0) return -1;
+    p.can_id = v;
+    if (parse_uint(tok[2], 255, &v) < 0) return -1;
+    p.selector = v;
+    if (parse_timing(tok + 3, n - 3, &p.period_ms, &p.timeout_ms) < 0) return -1;
+
+    int mux = find_mux(b, p.can_id);
+    if (mux < 0 || b->n_pages >= INT16_MAX)
+        return -1;
+    if (grow((void **)&b->pages, &b->cap_pages, b->n_pages + 1, sizeof(p)) < 0)
+        return -1;
+    last_page[mux] = (int16_t)b->n_pages;
+    b->pages[b->n_pages++] = p;
+    return 0;
+}
+
+static void builder_free(struct sdb_builder *b) {
+    free(b->signals);
+    free(b->pages);
+    free(b->muxes);
+    free(b->messages);
+    free(b->strings);
+}
+
+static int parse_text(struct sdb_builder *b, const char *text) {
+    int16_t last_page[256];
+    char line[512];
+    int lineno = 0;
+
+    memset(b, 0, sizeof(*b));
+    memset(last_page, -1, sizeof(last_page));
+
+    while (*text) {
+        size_t len = strcspn(text, "\n");
+        lineno++;
+        if (len >= sizeof(line)) {
+            fprintf(stderr, "signal db: line %d too long\n", lineno);
+            return -1;
+        }
+        memcpy(line, text, len);
+        line[len] = '\0';
+        text += len + (text[len] == '\n');
+
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *tok[SDB_MAX_TOKENS];
+        int n = 0;
+        char *save;
+        for (char *t = strtok_r(line, " \t\r", &save); t && n < SDB_MAX_TOKENS; t = strtok_r(NULL, " \t\r", &save))
+            tok[n++] = t;
+        if (n == 0)
+            continue;
+
+        int ret;
+        if (strcmp(tok[0], "sig") == 0)
+            ret = parse_sig(b, tok, n, last_page);
+        else if (strcmp(tok[0], "mux") == 0)
+            ret = (b->n_muxes < 256) ? parse_mux(b, tok, n) : -1;
+        else if (strcmp(tok[0], "page") == 0)
+            ret = parse_page(b, tok, n, last_page);
+        else if (strcmp(tok[0], "msg") == 0)
+            ret = parse_msg(b, tok, n);
+        else
+            ret = -1;
+
+        if (ret < 0) {
+            fprintf(stderr, "signal db: invalid entry on line %d\n", lineno);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ============ Blob Builder ============
+static const struct sdb_builder *sort_ctx;
+static pthread_mutex_t sort_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int cmp_page(const void *a, const void *b) {
+    const struct sdb_page *pa = &sort_ctx->pages[*(const uint32_t *)a];
+    const struct sdb_page *pb = &sort_ctx->pages[*(const uint32_t *)b];
+    if (pa->can_id != pb->can_id) return (pa->can_id < pb->can_id) ? -1 : 1;
+    return (int)pa->selector - (int)pb->selector;
+}
+
+static int cmp_signal(const void *a, const void *b) {
+    uint32_t ia = *(const uint32_t *)a, ib = *(const uint32_t *)b;
+    const struct sdb_signal *sa = &sort_ctx->signals[ia];
+    const struct sdb_signal *sb = &sort_ctx->signals[ib];
+    if (sa->can_id != sb->can_id) return (sa->can_id < sb->can_id) ? -1 : 1;
+    if (sa->page != sb->page)     return (sa->page < sb->page) ? -1 : 1;
+    return (ia < ib) ? -1 : (ia > ib);
+}
+
+static size_t align8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+/*
+ * Lays the database out as one position-independent blob: pages sorted by
+ * (id, selector), signals grouped by (id, page), so every message and page
+ * owns a contiguous run of signals.
+ */
+static void *build_blob(struct sdb_builder *b, size_t *size_out) {
+    size_t sig_off = align8(sizeof(struct sdb_header));
+    size_t page_off = sig_off + b->n_signals * sizeof(struct sdb_signal);
+    size_t mux_off = page_off + b->n_pages * sizeof(struct sdb_page);
+    size_t msg_off = mux_off + b->n_muxes * sizeof(struct sdb_mux);
+    size_t str_off = msg_off + b->n_messages * sizeof(struct sdb_message);
+    size_t size = align8(str_off + b->strings_size);
+
+    uint32_t *page_order = malloc((b->n_pages + 1) * sizeof(uint32_t));
+    uint32_t *page_rank  = malloc((b->n_pages + 1) * sizeof(uint32_t));
+    uint32_t *sig_order  = malloc((b->n_signals + 1) * sizeof(uint32_t));
+    uint8_t *blob = calloc(1, size);
+    if (!page_order || !page_rank || !sig_order || !blob) {
+        free(page_order); free(page_rank); free(sig_order); free(blob);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&sort_lock);
+    sort_ctx = b;
+    for (size_t i = 0; i < b->n_pages; i++)
+        page_order[i] = i;
+    qsort(page_order, b->n_pages, sizeof(uint32_t), cmp_page);
+    for (size_t i = 0; i < b->n_pages; i++)
+        page_rank[page_order[i]] = i;
+    for (size_t i = 0; i < b->n_signals; i++)
+        if (b->signals[i].page >= 0)
+            b->signals[i].page = (int16_t)page_rank[b->signals[i].page];
+
+    for (size_t i = 0; i < b->n_signals; i++)
+        sig_order[i] = i;
+    qsort(sig_order, b->n_signals, sizeof(uint32_t), cmp_signal);
+    pthread_mutex_unlock(&sort_lock);
+
+    struct sdb_header *hdr = (struct sdb_header *)blob;
+    hdr->magic        = SDB_MAGIC;
+    hdr->format       = SDB_FORMAT;
+    hdr->size         = size;
+    hdr->n_signals    = b->n_signals;
+    hdr->n_pages      = b->n_pages;
+    hdr->n_muxes      = b->n_muxes;
+    hdr->strings_size = b->strings_size;
+    hdr->n_messages   = b->n_messages;
+
+    for (size_t i = 0; i < b->n_signals; i++)
+        memcpy(blob + sig_off + i * sizeof(struct sdb_signal), &b->signals[sig_order[i]], sizeof(struct sdb_signal));
+    for (size_t i = 0; i < b->n_pages; i++)
+        memcpy(blob + page_off + i * sizeof(struct sdb_page), &b->pages[page_order[i]], sizeof(struct sdb_page));
+    memcpy(blob + mux_off, b->muxes, b->n_muxes * sizeof(struct sdb_mux));
+    memcpy(blob + msg_off, b->messages, b->n_messages * sizeof(struct sdb_message));
+    memcpy(blob + str_off, b->strings, b->strings_size);
+
+    free(page_order);
+    free(page_rank);
+    free(sig_order);
+    *size_out = size;
+    return blob;
+}
+
+// ============ Runtime Build ============
+static atomic_uint db_generation;
+
+static const char *blob_string(const struct sdb_header *hdr, const char *strings, uint32_t off) {
+    return (off < hdr->strings_size) ? strings + off : NULL;
+}
+
+static int64_t limit_raw(const struct can_signal *sig, double phys, int64_t none) {
+    return isnan(phys) ? none : signal_raw_from_phys(sig, phys);
+}
+
+// Slots of the published databases by signal name, kept across reloads; under db_writer
+struct slot_registry {
+    char   **names;             // per slot handed out
+    uint32_t n;
+    uint32_t capacity;          // fixed by the first database
+};
+
+static int32_t slot_find(char *const *names, uint32_t n, const char *name) {
+    for (uint32_t s = 0; s < n; s++)
+        if (strcmp(names[s], name) == 0)
+            return (int32_t)s;
+    return -1;
+}
+
+// Slots by name from the registry, new names taking the next free ones; a standalone
+// database (reg NULL) numbers them by signal. Signals wider than a slot get none.
+// The registry only takes the new names once the whole database is valid
+static uint32_t slots_assign(struct slot_registry *reg, const struct can_signal *signals, size_t n,
+                             int32_t *slot, int32_t *slot_signal, uint32_t n_slots) {
+    uint32_t added = 0;
+
+    for (uint32_t s = 0; s < n_slots; s++)
+        slot_signal[s] = -1;
+    for (size_t i = 0; i < n; i++) {
+        const struct can_signal *sig = &signals[i];
+        int32_t s = (reg != NULL) ? slot_find(reg->names, reg->n + added, sig->name) : (int32_t)i;
+
+        slot[i] = -1;
+        // Slot values travel as int32_t (vehicle state, watch, filters)
+        if (sig->length > (sig->is_signed ? 32 : 31)) {
+            if (reg != NULL)
+                fprintf(stderr, "signal db: %s needs %s%u raw bits, a slot holds 32 signed: not shown\n",
+                        sig->name, sig->is_signed ? "signed " : "", sig->length);
+            continue;
+        }
+        if (s < 0 && reg->n + added == n_slots) {
+            fprintf(stderr, "signal db: no slot left for %s until restarted (%u in use)\n", sig->name, n_slots);
+            continue;
+        }
+        if (s < 0) {
+            s = reg->n + added++;
+            reg->names[s] = (char *)sig->name;     // the database's own string until taken
+        }
+        if (slot_signal[s] < 0) {
+            slot[i] = s;
+            slot_signal[s] = (int32_t)i;
+        }
+    }
+    return added;
+}
+
+static int slots_take(struct slot_registry *reg, uint32_t added) {
+    for (uint32_t s = reg->n; s < reg->n + added; s++)
+        if ((reg->names[s] = strdup(reg->names[s])) == NULL)
+            return -1;
+    reg->n += added;
+    return 0;
+}
+
+/*
+ * Validates a blob and builds the runtime tables in a single allocation.
+ * Takes ownership of the blob (freed or unmapped with the database).
+ */
+static struct signal_db *build_runtime(void *blob, size_t blob_size, int mapped, struct slot_registry *reg) {
+    const struct sdb_header *hdr = blob;
+    size_t sig_off  = align8(sizeof(struct sdb_header));
+    size_t page_off = sig_off + (size_t)hdr->n_signals * sizeof(struct sdb_signal);
+    size_t mux_off  = page_off + (size_t)hdr->n_pages * sizeof(struct sdb_page);
+    size_t msg_off  = mux_off + (size_t)hdr->n_muxes * sizeof(struct sdb_mux);
+    size_t str_off  = msg_off + (size_t)hdr->n_messages * sizeof(struct sdb_message);
+
+    if (blob_size < sizeof(*hdr) || hdr->magic != SDB_MAGIC || hdr->format != SDB_FORMAT ||
+        hdr->size > blob_size || hdr->n_signals > UINT16_MAX || hdr->n_muxes > 256 ||
+        hdr->n_pages > INT16_MAX || hdr->n_messages > SDB_MAX_ID ||
+        str_off + hdr->strings_size > hdr->size ||
+        (hdr->strings_size && ((const char *)blob)[str_off + hdr->strings_size - 1] != '\0')) {
+        fprintf(stderr, "signal db: corrupt or incompatible database\n");
+        goto fail_blob;
+    }
+
+    const struct sdb_signal *rec = (const void *)((const uint8_t *)blob + sig_off);
+    const struct sdb_page *pages = (const void *)((const uint8_t *)blob + page_off);
+    const struct sdb_mux *muxes  = (const void *)((const uint8_t *)blob + mux_off);
+    const struct sdb_message *periods = (const void *)((const uint8_t *)blob + msg_off);
+    const char *strings          = (const char *)blob + str_off;
+    size_t n = hdr->n_signals;
+    size_t max_msgs = n + hdr->n_muxes + hdr->n_messages;
+    size_t max_monitors = hdr->n_messages + hdr->n_pages;
+
+    if (reg != NULL && reg->names == NULL) {
+        uint32_t capacity = (n + SDB_SLOTS_SPARE < UINT16_MAX) ? n + SDB_SLOTS_SPARE : UINT16_MAX;
+        if ((reg->names = calloc(capacity, sizeof(*reg->names))) == NULL)
+            goto fail_blob;
+        reg->capacity = capacity;
+    }
+    uint32_t n_slots = (reg != NULL) ? reg->capacity : n;
+
+    size_t size = align8(sizeof(struct signal_db))
+                + align8(n * sizeof(struct can_signal))
+                + align8(n * sizeof(struct fixed_format))
+                + align8(n * sizeof(int64_t)) * 2
+                + align8(n * sizeof(int32_t))
+                + align8(n_slots * sizeof(int32_t))
+                + align8(max_msgs * sizeof(struct signal_db_message))
+                + align8(hdr->n_pages * sizeof(struct can_mux_page))
+                + align8(hdr->n_muxes * sizeof(struct can_mux_message))
+                + align8(max_monitors * sizeof(struct signal_db_monitor))
+                + align8(2 * n * sizeof(uint32_t))
+                + align8(hdr->n_pages * sizeof(int32_t));
+    uint8_t *arena = calloc(1, size);
+    if (!arena)
+        goto fail_blob;
+
+    uint8_t *p = arena;
+    struct signal_db *db          = (void *)p; p += align8(sizeof(*db));
+    struct can_signal *signals    = (void *)p; p += align8(n * sizeof(*signals));
+    struct fixed_format *fmt      = (void *)p; p += align8(n * sizeof(*fmt));
+    int64_t *lo                   = (void *)p; p += align8(n * sizeof(*lo));
+    int64_t *hi                   = (void *)p; p += align8(n * sizeof(*hi));
+    int32_t *slot                 = (void *)p; p += align8(n * sizeof(*slot));
+    int32_t *slot_signal          = (void *)p; p += align8(n_slots * sizeof(*slot_signal));
+    struct signal_db_message *msg = (void *)p; p += align8(max_msgs * sizeof(*msg));
+    struct can_mux_page *mpages   = (void *)p; p += align8(hdr->n_pages * sizeof(*mpages));
+    struct can_mux_message *mmsg  = (void *)p; p += align8(hdr->n_muxes * sizeof(*mmsg));
+    struct signal_db_monitor *mon = (void *)p; p += align8(max_monitors * sizeof(*mon));
+    uint32_t *mon_slots           = (void *)p; p += align8(2 * n * sizeof(*mon_slots));
+    int32_t *page_monitor         = (void *)p;
+
+    // Signals: codec view, display format, limits
+    for (size_t i = 0; i < n; i++) {
+        const char *name = blob_string(hdr, strings, rec[i].name_off);
+        if (!name || !blob_string(hdr, strings, rec[i].unit_off) || rec[i].can_id >= SDB_MAX_ID ||
+            rec[i].length == 0 || rec[i].length > 64 || rec[i].start_bit + rec[i].length > 64 ||
+            rec[i].page >= (int32_t)hdr->n_pages || (i > 0 && rec[i].can_id < rec[i - 1].can_id) ||
+            (rec[i].page >= 0 && pages[rec[i].page].can_id != rec[i].can_id) ||
+            rec[i].byte_order > SIG_BIG_ENDIAN || rec[i].is_signed > 1 || rec[i].decimals > SDB_MAX_DECIMALS ||
+            // Messages take their plain signals as the run before the first paged one
+            (i > 0 && rec[i].can_id == rec[i - 1].can_id && rec[i].page < 0 && rec[i - 1].page >= 0) ||
+            !filter_valid(&(struct filter_spec){rec[i].filter, rec[i].filter_param}))
+            goto fail_arena;
+
+        signals[i] = (struct can_signal){name, rec[i].can_id, rec[i].start_bit, rec[i].length,
+                                         rec[i].byte_order, rec[i].is_signed, rec[i].factor, rec[i].offset};
+        signal_fixed_format(&signals[i], rec[i].decimals, &fmt[i]);
+        lo[i] = limit_raw(&signals[i], rec[i].warn_lo, INT64_MIN);
+        hi[i] = limit_raw(&signals[i], rec[i].warn_hi, INT64_MAX);
+    }
+    uint32_t added = slots_assign(reg, signals, n, slot, slot_signal, n_slots);
+
+    // Pages: each owns the contiguous run of signals that reference it
+    for (size_t i = 0; i < hdr->n_pages; i++) {
+        mpages[i].selector  = pages[i].selector;
+        mpages[i].period_ms = pages[i].period_ms;
+        mpages[i].signals   = NULL;
+        mpages[i].count     = 0;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (rec[i].page < 0)
+            continue;
+        struct can_mux_page *pg = &mpages[rec[i].page];
+        if (pg->signals == NULL)
+            pg->signals = &signals[i];
+        else if (pg->signals + pg->count != &signals[i])
+            goto fail_arena;
+        pg->count++;
+    }
+
+    // Messages: one per id, plain signals first (sorted by page, -1 first)
+    size_t n_msgs = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (n_msgs > 0 && msg[n_msgs - 1].can_id == rec[i].can_id) {
+            if (rec[i].page < 0)
+                msg[n_msgs - 1].count++;
+            continue;
+        }
+        msg[n_msgs].can_id = rec[i].can_id;
+        msg[n_msgs].first  = i;
+        msg[n_msgs].count  = (rec[i].page < 0) ? 1 : 0;
+        msg[n_msgs].mux    = NULL;
+        msg[n_msgs].monitor = -1;
+        db->id_index[rec[i].can_id] = ++n_msgs;
+    }
+
+    for (size_t m = 0; m < hdr->n_muxes; m++) {
+        size_t first = 0, count = 0;
+        for (size_t i = 0; i < hdr->n_pages; i++) {
+            if (pages[i].can_id != muxes[m].can_id)
+                continue;
+            if (count == 0)
+                first = i;
+            count++;
+        }
+
+        mmsg[m].can_id     = muxes[m].can_id;
+        mmsg[m].selector   = (struct can_signal){"selector", muxes[m].can_id, muxes[m].start_bit,
+                                                 muxes[m].length, muxes[m].byte_order, 0, 1.0, 0.0};
+        mmsg[m].pages      = &mpages[first];
+        mmsg[m].page_count = count;
+        if (muxes[m].can_id >= SDB_MAX_ID || muxes[m].byte_order > SIG_BIG_ENDIAN || can_mux_init(&mmsg[m]) < 0)
+            goto fail_arena;
+
+        if (db->id_index[muxes[m].can_id] == 0) {
+            msg[n_msgs] = (struct signal_db_message){muxes[m].can_id, 0, 0, NULL, -1};
+            db->id_index[muxes[m].can_id] = ++n_msgs;
+        }
+        msg[db->id_index[muxes[m].can_id] - 1].mux = &mmsg[m];
+    }
+
+    // Deadlines: whole messages (which need not carry known signals), then pages
+    size_t n_mon = 0;
+    for (size_t i = 0; i < hdr->n_messages; i++) {
+        uint32_t id = periods[i].can_id;
+        if (id >= SDB_MAX_ID || periods[i].timeout_ms == 0)
+            goto fail_arena;
+        if (db->id_index[id] == 0) {
+            msg[n_msgs] = (struct signal_db_message){id, 0, 0, NULL, -1};
+            db->id_index[id] = ++n_msgs;
+        }
+        if (msg[db->id_index[id] - 1].monitor >= 0)
+            goto fail_arena;
+        msg[db->id_index[id] - 1].monitor = n_mon;
+        mon[n_mon++] = (struct signal_db_monitor){id, -1, 0, periods[i].timeout_ms, 0, 0};
+    }
+    for (size_t i = 0; i < hdr->n_pages; i++) {
+        page_monitor[i] = -1;
+        if (pages[i].timeout_ms == 0)
+            continue;
+        page_monitor[i] = n_mon;
+        mon[n_mon++] = (struct signal_db_monitor){pages[i].can_id, (int16_t)i, pages[i].selector, pages[i].timeout_ms, 0, 0};
+    }
+
+    // Slots each deadline covers: all of its message's signals, or its page's
+    uint32_t n_mon_slots = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < n; i++) {
+            if (slot[i] < 0)
+                continue;
+            int32_t covers[2] = {msg[db->id_index[rec[i].can_id] - 1].monitor,
+                                 (rec[i].page >= 0) ? page_monitor[rec[i].page] : -1};
+            for (int k = 0; k < 2; k++) {
+                if (covers[k] < 0)
+                    continue;
+                struct signal_db_monitor *m = &mon[covers[k]];
+                if (pass == 1)
+                    mon_slots[m->first_slot + m->n_slots] = slot[i];
+                m->n_slots++;
+            }
+        }
+        // Counted: lay the lists out and fill them
+        for (size_t m = 0; pass == 0 && m < n_mon; m++) {
+            mon[m].first_slot = n_mon_slots;
+            n_mon_slots += mon[m].n_slots;
+            mon[m].n_slots = 0;
+        }
+    }
+
+    if (reg != NULL && slots_take(reg, added) < 0) {
+        perror("signal db: slot names");
+        free(arena);
+        goto fail_blob;
+    }
+
+    db->generation  = atomic_fetch_add(&db_generation, 1) + 1;
+    db->n_signals   = n;
+    db->n_messages  = n_msgs;
+    db->signals     = signals;
+    db->records     = rec;
+    db->fmt         = fmt;
+    db->warn_lo_raw = lo;
+    db->warn_hi_raw = hi;
+    db->n_slots     = n_slots;
+    db->slot        = slot;
+    db->slot_signal = slot_signal;
+    db->messages    = msg;
+    db->n_monitors  = n_mon;
+    db->monitors    = mon;
+    db->monitor_slots = mon_slots;
+    db->pages       = mpages;
+    db->page_monitor = page_monitor;
+    db->blob        = blob;
+    db->blob_size   = blob_size;
+    db->mapped      = mapped;
+    return db;
+
+fail_arena:
+    fprintf(stderr, "signal db: inconsistent signal table\n");
+    free(arena);
+fail_blob:
+    if (mapped)
+        munmap(blob, blob_size);
+    else
+        free(blob);
+    return NULL;
+}
+
+// ============ Load / Compile ============
+static struct signal_db *load_text(const char *text, struct slot_registry *reg) {
+    struct sdb_builder b;
+    size_t size;
+    void *blob = NULL;
+
+    if (parse_text(&b, text) == 0)
+        blob = build_blob(&b, &size);
+    builder_free(&b);
+    if (!blob)
+        return NULL;
+    return build_runtime(blob, size, 0, reg);
+}
+
+struct signal_db *signal_db_load_text(const char *text) {
+    return load_text(text, NULL);
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror("signal db: open failed");
+        return NULL;
+    }
+
+    size_t cap = 4096, len = 0, got;
+    char *buf = malloc(cap);
+    while (buf && (got = fread(buf + len, 1, cap - len - 1, f)) > 0) {
+        len += got;
+        if (len + 1 == cap) {
+            char *nbuf = realloc(buf, cap *= 2);
+            if (!nbuf) { free(buf); buf = NULL; }
+            else buf = nbuf;
+        }
+    }
+    fclose(f);
+    if (buf)
+        buf[len] = '\0';
+    return buf;
+}
+
+// Binary databases are mapped and used in place; text is parsed first
+static struct signal_db *load_file(const char *path, struct slot_registry *reg) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("signal db: open failed");
+        return NULL;
+    }
+
+    uint32_t magic = 0;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct sdb_header) &&
+        pread(fd, &magic, sizeof(magic), 0) == sizeof(magic) && magic == SDB_MAGIC) {
+        void *blob = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (blob == MAP_FAILED) {
+            perror("signal db: mmap failed");
+            return NULL;
+        }
+        return build_runtime(blob, st.st_size, 1, reg);
+    }
+    close(fd);
+
+    char *text = read_file(path);
+    if (!text)
+        return NULL;
+    struct signal_db *db = load_text(text, reg);
+    free(text);
+    return db;
+}
+
+struct signal_db *signal_db_load(const char *path) {
+    return load_file(path, NULL);
+}
+
+int32_t signal_db_lookup(const struct signal_db *db, const char *name) {
+    for (uint32_t i = 0; i < db->n_signals; i++)
+        if (strcmp(db->signals[i].name, name) == 0)
+            return (int32_t)i;
+    return -1;
+}
+
+void signal_db_free(struct signal_db *db) {
+    if (!db)
+        return;
+    if (db->mapped)
+        munmap(db->blob, db->blob_size);
+    else
+        free(db->blob);
+    free(db);
+}
+
+int signal_db_compile(const char *text_path, const char *out_path) {
+    struct sdb_builder b;
+    size_t size;
+    void *blob = NULL;
+    char *text = read_file(text_path);
+    if (!text)
+        return -1;
+
+    if (parse_text(&b, text) == 0)
+        blob = build_blob(&b, &size);
+    builder_free(&b);
+    free(text);
+    if (!blob)
+        return -1;
+
+    // Validate before writing
+    struct signal_db *db = build_runtime(blob, size, 0, NULL);
+    if (!db)
+        return -1;
+
+    // A running dashboard may have out_path mapped: write a new file and rename it over,
+    // so readers keep the old inode and the watch sees IN_MOVED_TO
+    char tmp_path[4096];
+    int ret = 0;
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "signal db: %s: path too long\n", out_path);
+        signal_db_free(db);
+        return -1;
+    }
+
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f || fwrite(db->blob, 1, size, f) != size || fflush(f) != 0 || fsync(fileno(f)) < 0) {
+        perror("signal db: write failed");
+        ret = -1;
+    }
+    if (f && fclose(f) != 0)
+        ret = -1;
+    if (ret == 0 && rename(tmp_path, out_path) < 0) {
+        perror("signal db: rename failed");
+        ret = -1;
+    }
+    if (ret < 0 && f)
+        unlink(tmp_path);
+    signal_db_free(db);
+    return ret;
+}
+
+// ============ Published Database ============
+static _Atomic(struct signal_db *) db_current;
+static atomic_int db_readers[2];
+static atomic_uint db_epoch;
+static pthread_mutex_t db_writer = PTHREAD_MUTEX_INITIALIZER;
+static const char *db_path;
+static struct slot_registry db_slots;
+
+const struct signal_db *signal_db_acquire(int *token) {
+    int e = atomic_load(&db_epoch) & 1;
+    atomic_fetch_add(&db_readers[e], 1);
+    *token = e;
+    return atomic_load(&db_current);
+}
+
+void signal_db_release(int token) {
+    atomic_fetch_sub(&db_readers[token], 1);
+}
+
+// Waits until every reader that could still hold the old pointer is done
+static void db_synchronize(void) {
+    for (int pass = 0; pass < 2; pass++) {
+        int e = atomic_fetch_add(&db_epoch, 1) & 1;
+        while (atomic_load(&db_readers[e]) != 0)
+            sched_yield();
+    }
+}
+
+static void db_publish(struct signal_db *db) {
+    struct signal_db *old = atomic_exchange(&db_current, db);
+    db_synchronize();
+    signal_db_free(old);
+}
+
+// Loaded under the writer lock, which also guards the slot registry
+int signal_db_init(const char *path) {
+    struct signal_db *db;
+
+    db_path = path;
+    pthread_mutex_lock(&db_writer);
+    db = path ? load_file(path, &db_slots) : load_text(signal_db_default_text, &db_slots);
+    if (db)
+        db_publish(db);
+    pthread_mutex_unlock(&db_writer);
+    return db ? 0 : -1;
+}
+
+// Keeps the current database if the new one fails to load
+int signal_db_reload(void) {
+    if (!db_path)
+        return -1;
+
+    pthread_mutex_lock(&db_writer);
+    struct signal_db *db = load_file(db_path, &db_slots);
+    if (db)
+        db_publish(db);
+    pthread_mutex_unlock(&db_writer);
+    return db ? 0 : -1;
+}
+
+void signal_db_shutdown(void) {
+    pthread_mutex_lock(&db_writer);
+    db_publish(NULL);
+    for (uint32_t s = 0; s < db_slots.n; s++)
+        free(db_slots.names[s]);
+    free(db_slots.names);
+    memset(&db_slots, 0, sizeof(db_slots));
+    pthread_mutex_unlock(&db_writer);
+}
+
+// ============ File Watch ============
+// Watches the directory so editors that save via rename are seen too
+int signal_db_watch(void) {
+    if (!db_path)
+        return -1;
+
+    char dir[4096];
+    snprintf(dir, sizeof(dir), "%s", db_path);
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        perror("inotify_init1 failed");
+        return -1;
+    }
+    if (inotify_add_watch(fd, dirname(dir), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        perror("inotify_add_watch failed");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int signal_db_watch_changed(int fd) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char name[4096];
+    int changed = 0;
+    ssize_t len;
+
+    snprintf(name, sizeof(name), "%s", db_path);
+    const char *base = basename(name);
+
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            if (ev->len > 0 && strcmp(ev->name, base) == 0)
+                changed = 1;
+            p += sizeof(*ev) + ev->len;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,163 @@
+#ifndef SIGNAL_DB_H
+#define SIGNAL_DB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "signal_codec.h"
+
+/*
+ * Runtime signal database.
+ *
+ * Definitions come from a text file (see signals.db) or from the binary form
+ * produced by signal_dbc, which is mapped as-is. A loaded database is
+ * immutable; a reload builds a new one and swaps it in RCU-style, so the
+ * receive path never waits for a reload:
+ *
+ *   int token;
+ *   const struct signal_db *db = signal_db_acquire(&token);
+ *   ... decode with db ...
+ *   signal_db_release(token);
+ *
+ * Every signal that fits in 32 raw bits gets an application slot, the
+ * index the vehicle state, history, filters and alarms keep it under.
+ * The published database hands slots out by name and keeps them across
+ * reloads, so a signal keeps its slot (and everything kept under it) for
+ * the life of the process. The first database loaded fixes how many
+ * slots there are: its signals plus SDB_SLOTS_SPARE for reloads to add;
+ * signals beyond that get no slot until the next start.
+ */
+
+#define SDB_MAGIC   0x42445343  // "CSDB"
+#define SDB_FORMAT  3
+#define SDB_MAX_ID  0x800       // standard 11-bit identifiers only
+#define SDB_TIMEOUT_PERIODS  3  // deadline when only a period is given
+#define SDB_SLOTS_SPARE  32     // slots for signals a reload adds
+
+// ============ Binary Form ============
+struct sdb_header {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t size;              // total bytes, header included
+    uint32_t n_signals;
+    uint32_t n_pages;
+    uint32_t n_muxes;
+    uint32_t strings_size;
+    uint32_t n_messages;
+};
+
+struct sdb_signal {
+    uint32_t name_off;          // into the string table
+    uint32_t unit_off;
+    uint32_t can_id;
+    int16_t  page;              // index into the page table, -1 if not multiplexed
+    uint8_t  start_bit;
+    uint8_t  length;
+    uint8_t  byte_order;
+    uint8_t  is_signed;
+    uint8_t  decimals;
+    uint8_t  filter;            // FILTER_* smoothing before display
+    int32_t  filter_param;
+    int64_t  deadband;          // raw units
+    double   factor;
+    double   offset;
+    double   warn_lo;           // NaN if unset
+    double   warn_hi;
+};
+
+struct sdb_page {
+    uint32_t can_id;
+    uint32_t period_ms;
+    uint32_t timeout_ms;        // 0: not monitored
+    uint8_t  selector;
+    uint8_t  reserved[3];
+};
+
+// Expected period of a whole message, for deadline monitoring
+struct sdb_message {
+    uint32_t can_id;
+    uint32_t period_ms;
+    uint32_t timeout_ms;
+    uint32_t reserved;
+};
+
+struct sdb_mux {
+    uint32_t can_id;
+    uint8_t  start_bit;
+    uint8_t  length;
+    uint8_t  byte_order;
+    uint8_t  reserved;
+};
+
+// ============ Runtime Form ============
+struct signal_db_message {
+    uint32_t can_id;
+    uint32_t first;             // first plain signal (index into signals)
+    uint32_t count;
+    const struct can_mux_message *mux;  // NULL for plain messages
+    int32_t  monitor;           // deadline of the whole message, -1 if none
+};
+
+// A deadline: a message, or one page of a multiplexed message, that must keep arriving
+struct signal_db_monitor {
+    uint32_t can_id;
+    int16_t  page;              // index into pages, -1 for the whole message
+    uint8_t  selector;
+    uint32_t timeout_ms;
+    uint32_t first_slot;        // its slots: monitor_slots[first_slot .. + n_slots)
+    uint32_t n_slots;
+};
+
+struct signal_db {
+    uint32_t generation;
+    uint32_t n_signals;
+    uint32_t n_messages;
+    const struct can_signal *signals;
+    const struct sdb_signal *records;   // unit, deadband, limits per signal
+    const struct fixed_format *fmt;     // per signal, from its decimals
+    const int64_t *warn_lo_raw;         // INT64_MIN if unset
+    const int64_t *warn_hi_raw;         // INT64_MAX if unset
+    uint32_t n_slots;                   // application slots, fixed for the process
+    const int32_t *slot;                // signal -> application slot, -1 if it has none
+    const int32_t *slot_signal;         // application slot -> signal, -1 if missing
+    const struct signal_db_message *messages;
+    uint16_t id_index[SDB_MAX_ID];      // can_id -> message + 1, 0 if unknown
+
+    uint32_t n_monitors;
+    const struct signal_db_monitor *monitors;
+    const uint32_t *monitor_slots;      // slots carried, per monitor
+    const struct can_mux_page *pages;   // all pages; a decoded page's index is page - pages
+    const int32_t *page_monitor;        // page -> monitor, -1 if none
+
+    // Storage, owned by the database
+    void *blob;
+    size_t blob_size;
+    int mapped;
+};
+
+static inline const struct signal_db_message *signal_db_message(const struct signal_db *db, uint32_t can_id) {
+    if (can_id >= SDB_MAX_ID || db->id_index[can_id] == 0)
+        return NULL;
+    return &db->messages[db->id_index[can_id] - 1];
+}
+
+// Loading and compiling. Standalone databases number their slots by signal
+struct signal_db *signal_db_load(const char *path);
+struct signal_db *signal_db_load_text(const char *text);
+void signal_db_free(struct signal_db *db);
+// Index of the signal called name, -1 if the database has none
+int32_t signal_db_lookup(const struct signal_db *db, const char *name);
+int  signal_db_compile(const char *text_path, const char *out_path);
+extern const char signal_db_default_text[];  // signals.db, built in
+
+// Published database (RCU-style swap)
+int  signal_db_init(const char *path);
+int  signal_db_reload(void);
+const struct signal_db *signal_db_acquire(int *token);
+void signal_db_release(int token);
+void signal_db_shutdown(void);
+
+// File watch: fd becomes readable on changes, signal_db_watch_changed() drains it
+int  signal_db_watch(void);
+int  signal_db_watch_changed(int fd);
+
+#endif
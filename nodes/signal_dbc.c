@@ -0,0 +1,23 @@
+/*
+ * signal_dbc - Signal database compiler
+ * Compiles a text signal database into the binary form that the dashboard
+ * maps directly at startup, skipping parsing and index construction.
+ *
+ *   signal_dbc signals.db signals.sdb
+ */
+
+#include <stdio.h>
+#include "signal_db.h"
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <signals.db> <signals.sdb>\n", argv[0]);
+        return 1;
+    }
+
+    if (signal_db_compile(argv[1], argv[2]) < 0) {
+        fprintf(stderr, "Failed to compile %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
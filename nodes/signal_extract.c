@@ -0,0 +1,345 @@
+/*
+ * signal_extract - Offline bulk signal decoder
+ * Pulls one signal out of a binary frame log (struct can_frame records, as
+ * read from a CAN_RAW socket) and prints its physical values.
+ *
+ *   signal_extract -s coolant_temp frames.log
+ *   signal_extract -s tyre_pressure -f median:5 frames.log   (smoothed)
+ *   signal_extract -s tyre_pressure -f median:5 -c frames.log   (check)
+ *   signal_extract -s tyre_pressure -b 100000000   (throughput benchmark)
+ *
+ * Signals come from the built-in database, or from -d <signals.db | .sdb>.
+ */
+
+#include <linux/can.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "signal_codec.h"
+#include "signal_db.h"
+#include "signal_filter.h"
+
+#define BLOCK_FRAMES 4096
+#define CHECK_BURST  64     // the dashboard's RX_BURST_MAX
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog, const struct signal_db *db) {
+    fprintf(stderr, "Usage: %s [-d signal_db] -s <signal> [-f <filter>] [-q] <frames.log>\n", prog);
+    fprintf(stderr, "       %s [-d signal_db] -s <signal> -f <filter> -c <frames.log>\n", prog);
+    fprintf(stderr, "       %s [-d signal_db] -s <signal> -b <frames>\n", prog);
+    fprintf(stderr, "  -d  signal database (text or signal_dbc binary), default the built-in one\n");
+    fprintf(stderr, "  -f  smooth the values: ema:<k>, median:<n>, rate:<raw step> (as in signals.db)\n");
+    fprintf(stderr, "  -c  check that the dashboard's receive bursts filter the log as -f does\n");
+    fprintf(stderr, "  -q  print a summary instead of every value\n");
+    fprintf(stderr, "  -b  benchmark batch decode on <frames> synthetic payloads (checked against scalar first)\n");
+    if (db == NULL)
+        return;
+    fprintf(stderr, "Signals:");
+    for (uint32_t i = 0; i < db->n_signals; i++)
+        fprintf(stderr, " %s", db->signals[i].name);
+    fprintf(stderr, "\n");
+}
+
+// ============ Benchmark ============
+static int run_benchmark(const struct can_signal *sig, size_t count) {
+    uint8_t *payloads = malloc(count * 8);
+    double *out = malloc(count * sizeof(double));
+    if (!payloads || !out) {
+        perror("malloc failed");
+        free(payloads);
+        free(out);
+        return 1;
+    }
+
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count * 8; i++) {
+        seed = seed * 1103515245 + 12345;
+        payloads[i] = seed >> 16;
+    }
+
+    // Both paths must agree before either is timed
+    for (size_t i = 0; i < count; i += BLOCK_FRAMES) {
+        static double scalar[BLOCK_FRAMES], batch[BLOCK_FRAMES];
+        size_t n = (count - i < BLOCK_FRAMES) ? count - i : BLOCK_FRAMES;
+        signal_decode_batch_scalar(sig, payloads + i * 8, n, scalar);
+        signal_decode_batch(sig, payloads + i * 8, n, batch);
+        for (size_t j = 0; j < n; j++) {
+            if (memcmp(&scalar[j], &batch[j], sizeof(double)) != 0) {
+                fprintf(stderr, "%s differs from scalar at frame %zu: %.17g vs %.17g\n",
+                        signal_batch_impl(sig), i + j, batch[j], scalar[j]);
+                free(payloads);
+                free(out);
+                return 1;
+            }
+        }
+    }
+
+    memset(out, 0, count * sizeof(double));
+
+    double gb = count * 8 / 1e9;
+    double t0 = now_sec();
+    signal_decode_batch_scalar(sig, payloads, count, out);
+    double t1 = now_sec();
+    signal_decode_batch(sig, payloads, count, out);
+    double t2 = now_sec();
+
+    printf("signal:  %s, %zu frames (%.2f GB of payload)\n", sig->name, count, gb);
+    printf("scalar:  %.3f s  %.2f GB/s\n", t1 - t0, gb / (t1 - t0));
+    printf("%-7s  %.3f s  %.2f GB/s\n", signal_batch_impl(sig), t2 - t1, gb / (t2 - t1));
+
+    free(payloads);
+    free(out);
+    return 0;
+}
+
+// ============ Burst Check ============
+// The dashboard decodes every signal of the log into one bank, a step per receive burst
+// of 1..CHECK_BURST frames, and filter_bank_add steps early when a signal repeats.
+// Its outputs for sig must match one step per frame of sig alone.
+static int run_check(const struct signal_db *db, const struct can_signal *sig,
+                     const struct can_frame *frames, size_t total, const struct filter_spec *filter) {
+    uint32_t n = db->n_signals, self = sig - db->signals;
+    struct filter_spec *spec = malloc(n * sizeof(*spec));
+    struct filter_bank single, burst;
+
+    if (spec == NULL) {
+        perror("malloc failed");
+        return 1;
+    }
+    for (uint32_t k = 0; k < n; k++)
+        spec[k] = *filter;
+    if (filter_bank_init(&single, filter, 1) < 0) {
+        perror("filter bank failed");
+        free(spec);
+        return 1;
+    }
+    if (filter_bank_init(&burst, spec, n) < 0) {
+        perror("filter bank failed");
+        filter_bank_free(&single);
+        free(spec);
+        return 1;
+    }
+    free(spec);
+
+    int32_t *expect = malloc(total * sizeof(int32_t));
+    if (expect == NULL) {
+        perror("malloc failed");
+        filter_bank_free(&single);
+        filter_bank_free(&burst);
+        return 1;
+    }
+
+    size_t expected = 0, checked = 0, bursts = 0, mismatch = 0;
+    uint32_t seed = 12345, left = 0;
+    int waiting = 0;
+
+    for (size_t i = 0; i <= total; i++) {
+        if (left == 0 || i == total) {
+            // Burst ends: the samples still waiting take the burst's step
+            filter_bank_step(&burst);
+            if (waiting && filter_bank_get(&burst, self) != expect[checked++])
+                mismatch++;
+            waiting = 0;
+            if (i == total)
+                break;
+            seed = seed * 1103515245 + 12345;
+            left = 1 + (seed >> 16) % CHECK_BURST;
+            bursts++;
+        }
+        left--;
+
+        const struct can_frame *f = &frames[i];
+        const struct signal_db_message *msg = signal_db_message(db, f->can_id & CAN_SFF_MASK);
+        if (msg == NULL || (f->can_id & (CAN_RTR_FLAG | CAN_EFF_FLAG)))
+            continue;
+        const struct can_signal *s = &db->signals[msg->first];
+        size_t count = msg->count;
+        if (msg->mux) {
+            const struct can_mux_page *page = can_mux_decode(msg->mux, f->data);
+            if (page == NULL)
+                continue;
+            s = page->signals;
+            count = page->count;
+        }
+
+        for (size_t j = 0; j < count; j++) {
+            uint32_t k = &s[j] - db->signals;
+            int32_t raw = (int32_t)signal_extract_raw(&s[j], f->data);
+            if (filter_bank_add(&burst, k, raw) && waiting) {
+                if (filter_bank_get(&burst, self) != expect[checked++])
+                    mismatch++;
+                waiting = 0;
+            }
+            if (k == self) {
+                filter_bank_put(&single, 0, raw);
+                filter_bank_step(&single);
+                expect[expected++] = filter_bank_get(&single, 0);
+                waiting = 1;
+            }
+        }
+    }
+
+    printf("check:   %zu %s samples in %zu bursts, %zu differ from one step per frame\n",
+           checked, sig->name, bursts, mismatch);
+    free(expect);
+    filter_bank_free(&single);
+    filter_bank_free(&burst);
+    return (mismatch || checked != expected) ? 1 : 0;
+}
+
+// ============ Log Extraction ============
+// Smoothing runs on raw values through the dashboard's filter kernels, one step per frame
+static void filter_block(struct filter_bank *bank, const struct can_signal *sig,
+                         const uint8_t *column, size_t count, double *values) {
+    for (size_t j = 0; j < count; j++) {
+        filter_bank_put(bank, 0, (int32_t)signal_extract_raw(sig, column + j * 8));
+        filter_bank_step(bank);
+        values[j] = filter_bank_get(bank, 0) * sig->factor + sig->offset;
+    }
+}
+
+static int run_extract(const struct signal_db *db, const struct can_signal *sig, const char *path,
+                       int quiet, const struct filter_spec *filter, int check) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("open failed");
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "Empty or unreadable log: %s\n", path);
+        close(fd);
+        return 1;
+    }
+
+    const struct can_frame *frames = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (frames == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+    madvise((void *)frames, st.st_size, MADV_SEQUENTIAL);
+
+    if (check) {
+        int err = run_check(db, sig, frames, st.st_size / sizeof(struct can_frame), filter);
+        munmap((void *)frames, st.st_size);
+        return err;
+    }
+
+    struct filter_bank bank;
+    if (filter != NULL && filter_bank_init(&bank, filter, 1) < 0) {
+        perror("filter bank failed");
+        munmap((void *)frames, st.st_size);
+        return 1;
+    }
+
+    // Multiplexed signal: keep only frames that carry its page
+    const struct can_mux_message *mux = signal_db_message(db, sig->can_id)->mux;
+    const struct can_mux_page *page = mux ? can_mux_page_of(mux, sig) : NULL;
+
+    size_t total = st.st_size / sizeof(struct can_frame);
+    static uint8_t column[BLOCK_FRAMES * 8];
+    static double values[BLOCK_FRAMES];
+    size_t matched = 0, fill = 0;
+    double min = 0, max = 0, sum = 0;
+    double t0 = now_sec();
+
+    for (size_t i = 0; i <= total; i++) {
+        if (i < total && (frames[i].can_id & CAN_SFF_MASK) == sig->can_id &&
+            !(frames[i].can_id & (CAN_RTR_FLAG | CAN_EFF_FLAG)) &&
+            (page == NULL || can_mux_decode(mux, frames[i].data) == page)) {
+            memcpy(column + fill * 8, frames[i].data, 8);
+            fill++;
+        }
+
+        if (fill == BLOCK_FRAMES || (i == total && fill > 0)) {
+            if (filter != NULL)
+                filter_block(&bank, sig, column, fill, values);
+            else
+                signal_decode_batch(sig, column, fill, values);
+            for (size_t j = 0; j < fill; j++) {
+                if (!quiet)
+                    printf("%.2f\n", values[j]);
+                if (matched + j == 0 || values[j] < min) min = values[j];
+                if (matched + j == 0 || values[j] > max) max = values[j];
+                sum += values[j];
+            }
+            matched += fill;
+            fill = 0;
+        }
+    }
+
+    double elapsed = now_sec() - t0;
+    munmap((void *)frames, st.st_size);
+    if (filter != NULL)
+        filter_bank_free(&bank);
+
+    if (quiet) {
+        printf("frames:  %zu scanned, %zu matched %s (0x%03X)\n", total, matched, sig->name, sig->can_id);
+        if (matched)
+            printf("values:  min %.2f  max %.2f  mean %.2f\n", min, max, sum / matched);
+        printf("scan:    %.3f s  %.2f GB/s\n", elapsed, st.st_size / 1e9 / elapsed);
+    }
+    return 0;
+}
+
+// ============ MAIN ============
+int main(int argc, char *argv[]) {
+    const char *name = NULL, *db_path = NULL;
+    struct filter_spec filter;
+    int filtered = 0;
+    size_t bench_frames = 0;
+    int quiet = 0, check = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:b:f:qc")) != -1) {
+        switch (opt) {
+            case 's': name = optarg;                             break;
+            case 'd': db_path = optarg;                          break;
+            case 'b': bench_frames = strtoull(optarg, NULL, 0); break;
+            case 'q': quiet = 1;                                 break;
+            case 'c': check = 1;                                 break;
+            case 'f':
+                if (filter_parse(optarg, &filter) < 0) {
+                    fprintf(stderr, "Invalid filter: %s\n", optarg);
+                    return 1;
+                }
+                filtered = 1;
+                break;
+            default:  usage(argv[0], NULL); return 1;
+        }
+    }
+
+    struct signal_db *db = db_path ? signal_db_load(db_path)
+                                   : signal_db_load_text(signal_db_default_text);
+    if (db == NULL)
+        return 1;
+
+    int32_t index = name ? signal_db_lookup(db, name) : -1;
+    int err;
+    if (index < 0 || (bench_frames == 0 && (optind >= argc || (check && !filtered)))) {
+        usage(argv[0], db);
+        err = 1;
+    } else if (filtered && db->signals[index].length > (db->signals[index].is_signed ? 32 : 31)) {
+        fprintf(stderr, "%s does not fit the filters' 32-bit signed raw values\n", name);
+        err = 1;
+    } else if (bench_frames > 0) {
+        err = run_benchmark(&db->signals[index], bench_frames);
+    } else {
+        err = run_extract(db, &db->signals[index], argv[optind], quiet, filtered ? &filter : NULL, check);
+    }
+    signal_db_free(db);
+    return err;
+}
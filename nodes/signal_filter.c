@@ -0,0 +1,290 @@
+#include <stdlib.h>
+#include <string.h>
+#include "signal_filter.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_HAVE_AVX2 1
+#endif
+
+#define LANE_ARRAYS  7      // in, fresh, out, param, round, state, primed
+
+static const char *const kind_names[] = {
+    [FILTER_NONE] = "none", [FILTER_EMA] = "ema", [FILTER_MEDIAN] = "median", [FILTER_RATE] = "rate",
+};
+
+// ============ Specs ============
+int filter_valid(const struct filter_spec *spec) {
+    switch (spec->kind) {
+        case FILTER_NONE:   return 1;
+        case FILTER_EMA:    return spec->param >= 1 && spec->param <= FILTER_EMA_MAX;
+        case FILTER_MEDIAN: return spec->param >= 3 && spec->param <= FILTER_MEDIAN_MAX && (spec->param & 1);
+        case FILTER_RATE:   return spec->param >= 1;
+        default:            return 0;
+    }
+}
+
+int filter_parse(const char *text, struct filter_spec *spec) {
+    if (strcmp(text, "none") == 0) {
+        *spec = (struct filter_spec){.kind = FILTER_NONE};
+        return 0;
+    }
+
+    const char *colon = strchr(text, ':');
+    if (colon == NULL || colon[1] == '\0')
+        return -1;
+
+    for (int k = FILTER_EMA; k <= FILTER_RATE; k++) {
+        size_t len = strlen(kind_names[k]);
+        if ((size_t)(colon - text) != len || strncmp(text, kind_names[k], len) != 0)
+            continue;
+
+        char *end;
+        long v = strtol(colon + 1, &end, 0);
+        if (*end != '\0' || v < 0 || v > INT32_MAX)
+            return -1;
+        struct filter_spec s = {.kind = k, .param = (int32_t)v};
+        if (!filter_valid(&s))
+            return -1;
+        *spec = s;
+        return 0;
+    }
+    return -1;
+}
+
+static int group_of(const struct filter_spec *spec) {
+    switch (spec->kind) {
+        case FILTER_EMA:    return 1;
+        case FILTER_MEDIAN: return 2 + (spec->param - 3) / 2;
+        case FILTER_RATE:   return 5;
+        default:            return 0;
+    }
+}
+
+// ============ Setup ============
+int filter_bank_init(struct filter_bank *b, const struct filter_spec *spec, uint32_t n) {
+    uint32_t count[FILTER_GROUPS] = {0};
+
+    memset(b, 0, sizeof(*b));
+    for (uint32_t i = 0; i < n; i++) {
+        if (!filter_valid(&spec[i]))
+            return -1;
+        count[group_of(&spec[i])]++;
+    }
+
+    uint32_t lanes = 0;
+    for (int g = 0; g < FILTER_GROUPS; g++) {
+        b->group[g].kind   = (g == 0) ? FILTER_NONE : (g == 1) ? FILTER_EMA : (g == 5) ? FILTER_RATE : FILTER_MEDIAN;
+        b->group[g].length = (b->group[g].kind == FILTER_MEDIAN) ? 3 + 2 * (g - 2) : 0;
+        b->group[g].first  = lanes;
+        b->group[g].count  = (count[g] + FILTER_LANES - 1) / FILTER_LANES * FILTER_LANES;
+        lanes += b->group[g].count;
+    }
+
+    // Lane arrays first, each a whole number of vectors, then the signal map
+    size_t size = ((size_t)lanes * (LANE_ARRAYS + FILTER_MEDIAN_MAX) + n) * sizeof(int32_t);
+    size = (size + 63) / 64 * 64;
+    int32_t *mem = aligned_alloc(64, size ? size : 64);
+    if (mem == NULL)
+        return -1;
+    memset(mem, 0, size);
+
+    b->mem    = mem;
+    b->n      = n;
+    b->lanes  = lanes;
+    b->in     = mem;
+    b->fresh  = mem + lanes;
+    b->out    = mem + lanes * 2;
+    b->param  = mem + lanes * 3;
+    b->round  = mem + lanes * 4;
+    b->state  = mem + lanes * 5;
+    b->primed = mem + lanes * 6;
+    b->window = mem + lanes * LANE_ARRAYS;
+    b->lane   = (uint32_t *)(mem + lanes * (LANE_ARRAYS + FILTER_MEDIAN_MAX));
+
+    uint32_t next[FILTER_GROUPS];
+    for (int g = 0; g < FILTER_GROUPS; g++)
+        next[g] = b->group[g].first;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t l = next[group_of(&spec[i])]++;
+        b->lane[i] = l;
+        if (spec[i].kind == FILTER_EMA || spec[i].kind == FILTER_RATE)
+            b->param[l] = spec[i].param;
+        if (spec[i].kind == FILTER_EMA)
+            b->round[l] = 1 << (spec[i].param - 1);
+    }
+    return 0;
+}
+
+void filter_bank_free(struct filter_bank *b) {
+    free(b->mem);
+    memset(b, 0, sizeof(*b));
+}
+
+// ============ Scalar Step ============
+static inline void sort2(int32_t *a, int32_t *b) {
+    int32_t lo = (*a < *b) ? *a : *b;
+    int32_t hi = (*a < *b) ? *b : *a;
+    *a = lo;
+    *b = hi;
+}
+
+// Odd-even transposition sort; the vector step runs the same network
+static int32_t median_of(int32_t *v, int len) {
+    for (int round = 0; round < len; round++)
+        for (int i = round & 1; i + 1 < len; i += 2)
+            sort2(&v[i], &v[i + 1]);
+    return v[len / 2];
+}
+
+static inline int32_t clamp(int32_t x, int32_t limit) {
+    return (x > limit) ? limit : (x < -limit) ? -limit : x;
+}
+
+static int32_t step_lane(struct filter_bank *b, const struct filter_group *g, uint32_t l) {
+    int32_t x = b->in[l];
+    int primed = b->primed[l] != 0;
+
+    switch (g->kind) {
+        case FILTER_EMA: {
+            int32_t xs = clamp(x, FILTER_EMA_LIMIT) * (1 << FILTER_EMA_FRAC);
+            int32_t s  = b->state[l];
+            s = primed ? s + ((xs - s + b->round[l]) >> b->param[l]) : xs;
+            b->state[l] = s;
+            return (s + (1 << (FILTER_EMA_FRAC - 1))) >> FILTER_EMA_FRAC;
+        }
+        case FILTER_MEDIAN: {
+            int32_t v[FILTER_MEDIAN_MAX];
+            for (int r = 0; r < g->length; r++) {
+                int32_t *w = &b->window[(size_t)r * b->lanes + l];
+                *w = (primed && r + 1 < g->length) ? w[b->lanes] : x;
+                v[r] = *w;
+            }
+            return median_of(v, g->length);
+        }
+        case FILTER_RATE: {
+            x = clamp(x, FILTER_RATE_LIMIT);
+            int32_t y = b->out[l], d = x - y;
+            if (!primed)
+                return x;
+            if (d > b->param[l])  d = b->param[l];
+            if (d < -b->param[l]) d = -b->param[l];
+            return y + d;
+        }
+        default:
+            return x;
+    }
+}
+
+void filter_bank_step_scalar(struct filter_bank *b) {
+    for (int gi = 0; gi < FILTER_GROUPS; gi++) {
+        const struct filter_group *g = &b->group[gi];
+        for (uint32_t l = g->first; l < g->first + g->count; l++) {
+            if (!b->fresh[l])
+                continue;
+            b->out[l]    = step_lane(b, g, l);
+            b->primed[l] = -1;
+            b->fresh[l]  = 0;
+        }
+    }
+    b->steps++;
+}
+
+// ============ AVX2 Step ============
+#ifdef FILTER_HAVE_AVX2
+/*
+ * Eight lanes per register. Every lane of a group is computed and the
+ * fresh mask blends the result in, so lanes without a sample (and the
+ * padding) keep their state; unprimed lanes take the input as it is.
+ */
+__attribute__((target("avx2")))
+static inline __m256i clamp8(__m256i x, int32_t limit) {
+    return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_set1_epi32(-limit)), _mm256_set1_epi32(limit));
+}
+
+__attribute__((target("avx2")))
+static void filter_bank_step_avx2(struct filter_bank *b) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i half = _mm256_set1_epi32(1 << (FILTER_EMA_FRAC - 1));
+
+    for (int gi = 0; gi < FILTER_GROUPS; gi++) {
+        const struct filter_group *g = &b->group[gi];
+
+        for (uint32_t l = g->first; l < g->first + g->count; l += FILTER_LANES) {
+            __m256i x = _mm256_load_si256((const __m256i *)(b->in + l));
+            __m256i f = _mm256_load_si256((const __m256i *)(b->fresh + l));
+            __m256i p = _mm256_load_si256((const __m256i *)(b->primed + l));
+            __m256i y = _mm256_load_si256((const __m256i *)(b->out + l));
+            __m256i v = x;
+
+            if (_mm256_testz_si256(f, f))
+                continue;
+
+            if (g->kind == FILTER_EMA) {
+                __m256i s  = _mm256_load_si256((const __m256i *)(b->state + l));
+                __m256i xs = _mm256_slli_epi32(clamp8(x, FILTER_EMA_LIMIT), FILTER_EMA_FRAC);
+                __m256i d  = _mm256_add_epi32(_mm256_sub_epi32(xs, s),
+                                              _mm256_load_si256((const __m256i *)(b->round + l)));
+                __m256i ns = _mm256_add_epi32(s, _mm256_srav_epi32(d, _mm256_load_si256((const __m256i *)(b->param + l))));
+                s = _mm256_blendv_epi8(s, _mm256_blendv_epi8(xs, ns, p), f);
+                _mm256_store_si256((__m256i *)(b->state + l), s);
+                v = _mm256_srai_epi32(_mm256_add_epi32(s, half), FILTER_EMA_FRAC);
+            } else if (g->kind == FILTER_MEDIAN) {
+                __m256i w[FILTER_MEDIAN_MAX];
+                int len = g->length;
+
+                for (int r = 0; r < len; r++) {
+                    int32_t *row = b->window + (size_t)r * b->lanes + l;
+                    __m256i old = _mm256_load_si256((const __m256i *)row);
+                    __m256i shifted = (r + 1 < len) ? _mm256_load_si256((const __m256i *)(row + b->lanes)) : x;
+                    w[r] = _mm256_blendv_epi8(old, _mm256_blendv_epi8(x, shifted, p), f);
+                    _mm256_store_si256((__m256i *)row, w[r]);
+                }
+                for (int round = 0; round < len; round++)
+                    for (int i = round & 1; i + 1 < len; i += 2) {
+                        __m256i lo = _mm256_min_epi32(w[i], w[i + 1]);
+                        w[i + 1] = _mm256_max_epi32(w[i], w[i + 1]);
+                        w[i] = lo;
+                    }
+                v = w[len / 2];
+            } else if (g->kind == FILTER_RATE) {
+                __m256i step = _mm256_load_si256((const __m256i *)(b->param + l));
+                x = clamp8(x, FILTER_RATE_LIMIT);
+                __m256i d = _mm256_sub_epi32(x, y);
+                d = _mm256_min_epi32(_mm256_max_epi32(d, _mm256_sub_epi32(zero, step)), step);
+                v = _mm256_blendv_epi8(x, _mm256_add_epi32(y, d), p);
+            }
+
+            _mm256_store_si256((__m256i *)(b->out + l), _mm256_blendv_epi8(y, v, f));
+            _mm256_store_si256((__m256i *)(b->primed + l), _mm256_or_si256(p, f));
+            _mm256_store_si256((__m256i *)(b->fresh + l), zero);
+        }
+    }
+    b->steps++;
+}
+#endif
+
+static int use_avx2(void) {
+#ifdef FILTER_HAVE_AVX2
+    static int cached = -1;
+    if (cached < 0)
+        cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+    return cached;
+#else
+    return 0;
+#endif
+}
+
+void filter_bank_step(struct filter_bank *b) {
+#ifdef FILTER_HAVE_AVX2
+    if (use_avx2()) {
+        filter_bank_step_avx2(b);
+        return;
+    }
+#endif
+    filter_bank_step_scalar(b);
+}
+
+const char *filter_impl(void) {
+    return use_avx2() ? "avx2" : "scalar";
+}
@@ -0,0 +1,112 @@
+#ifndef SIGNAL_FILTER_H
+#define SIGNAL_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Smoothing filters for noisy signals, in fixed point on raw values.
+ *
+ *   ema:<k>      exponential moving average, y += (x - y) / 2^k   (k 1..8)
+ *   median:<n>   median of the last n samples                     (n 3, 5, 7)
+ *   rate:<d>     rate limiter, y moves at most d raw units a step (d >= 1)
+ *
+ * A bank holds the filters of many signals as structure-of-arrays lanes,
+ * grouped by filter, so a step runs every group as straight-line vector
+ * code: AVX2 where the CPU has it (8 signals per instruction), scalar
+ * otherwise, with identical results. Callers put the samples that arrived,
+ * step once per update tick and read the outputs back; a signal without
+ * a new sample keeps its state and output. A signal's first sample passes
+ * through and primes its filter.
+ *
+ *   filter_bank_put(&bank, signal, raw);   ... for each sample of the tick
+ *   filter_bank_step(&bank);
+ *   smoothed = filter_bank_get(&bank, signal);
+ *
+ * A put overwrites a sample still waiting for the step. Callers without a
+ * fixed tick use filter_bank_add, which steps the waiting sample through
+ * first, so every sample is filtered once and the outputs do not depend
+ * on how samples are grouped into steps.
+ *
+ * The EMA carries FILTER_EMA_FRAC fraction bits so it settles on a steady
+ * input exactly. Both steps clamp EMA inputs to +-FILTER_EMA_LIMIT and rate
+ * inputs to +-FILTER_RATE_LIMIT, so a garbage sample saturates the output
+ * the same way on either path instead of overflowing; the median takes any
+ * int32.
+ */
+
+#define FILTER_NONE     0
+#define FILTER_EMA      1
+#define FILTER_MEDIAN   2
+#define FILTER_RATE     3
+
+#define FILTER_EMA_FRAC    8
+#define FILTER_EMA_LIMIT   ((1 << (30 - FILTER_EMA_FRAC)) - 1)    // x << FRAC, minus the state, fits
+#define FILTER_RATE_LIMIT  ((1 << 30) - 1)                        // x - y fits
+#define FILTER_EMA_MAX     8    // largest k
+#define FILTER_MEDIAN_MAX  7    // longest window
+#define FILTER_LANES       8    // groups are padded to whole vectors
+#define FILTER_GROUPS      6    // none, ema, median 3 / 5 / 7, rate
+
+struct filter_spec {
+    uint8_t kind;
+    int32_t param;              // EMA k, median length, rate step (raw units)
+};
+
+struct filter_group {
+    uint8_t  kind;
+    uint8_t  length;            // median window
+    uint32_t first, count;      // lanes
+};
+
+struct filter_bank {
+    uint32_t n;                 // signals
+    uint32_t lanes;
+    struct filter_group group[FILTER_GROUPS];
+    uint32_t *lane;             // signal -> lane
+
+    // By lane
+    int32_t *in, *fresh, *out;  // fresh is -1 while a sample waits for the step
+    int32_t *param;             // EMA shift, rate step
+    int32_t *round;             // EMA rounding, half of 2^k
+    int32_t *state;             // EMA accumulator
+    int32_t *primed;            // -1 once the first sample went through
+    int32_t *window;            // median samples, FILTER_MEDIAN_MAX rows of lanes, oldest first
+
+    uint64_t steps;
+    void *mem;
+};
+
+// "none", "ema:3", "median:5", "rate:50"; -1 if invalid
+int  filter_parse(const char *text, struct filter_spec *spec);
+int  filter_valid(const struct filter_spec *spec);
+
+int  filter_bank_init(struct filter_bank *b, const struct filter_spec *spec, uint32_t n);
+void filter_bank_free(struct filter_bank *b);
+
+// Steps every signal that got a sample since the last step
+void filter_bank_step(struct filter_bank *b);
+void filter_bank_step_scalar(struct filter_bank *b);
+
+static inline void filter_bank_put(struct filter_bank *b, uint32_t signal, int32_t value) {
+    uint32_t l = b->lane[signal];
+    b->in[l]    = value;
+    b->fresh[l] = -1;
+}
+
+// 1 if it had to step the bank for a sample of this signal still waiting
+static inline int filter_bank_add(struct filter_bank *b, uint32_t signal, int32_t value) {
+    int stepped = b->fresh[b->lane[signal]] != 0;
+    if (stepped)
+        filter_bank_step(b);
+    filter_bank_put(b, signal, value);
+    return stepped;
+}
+
+static inline int32_t filter_bank_get(const struct filter_bank *b, uint32_t signal) {
+    return b->out[b->lane[signal]];
+}
+
+const char *filter_impl(void);
+
+#endif
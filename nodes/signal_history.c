@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include "signal_history.h"
+
+const struct history_tier_def history_tiers[HISTORY_TIERS] = {
+    {1000, 120}, {10000, 180}, {60000, 240},
+};
+
+static const uint32_t tier_offset[HISTORY_TIERS] = {0, 120, 120 + 180};
+_Static_assert(120 + 180 + 240 == HISTORY_BUCKETS, "tier rings do not fill the bucket array");
+
+static uint64_t tier_width_us(int t) {
+    return (uint64_t)history_tiers[t].width_ms * 1000;
+}
+
+static struct history_bucket *bucket_at(struct history_series *s, int t, uint64_t epoch) {
+    return &s->bucket[tier_offset[t] + epoch % history_tiers[t].len];
+}
+
+static void bucket_hold(struct history_bucket *b, int32_t value) {
+    b->min = b->max = value;
+    b->sum   = 0;
+    b->count = 0;
+}
+
+// ============ Setup ============
+int signal_history_init(struct signal_history *h, size_t count) {
+    h->series = calloc(count, sizeof(*h->series));
+    if (h->series == NULL)
+        return -1;
+
+    for (size_t i = 0; i < count; i++)
+        for (int b = 0; b < HISTORY_BUCKETS; b++) {
+            h->series[i].bucket[b].min = INT32_MAX;
+            h->series[i].bucket[b].max = INT32_MIN;
+        }
+    h->count = count;
+    pthread_mutex_init(&h->lock, NULL);
+    return 0;
+}
+
+void signal_history_free(struct signal_history *h) {
+    free(h->series);
+    h->series = NULL;
+    h->count  = 0;
+    pthread_mutex_destroy(&h->lock);
+}
+
+// ============ Update ============
+void signal_history_begin(struct signal_history *h) {
+    pthread_mutex_lock(&h->lock);
+}
+
+void signal_history_end(struct signal_history *h) {
+    pthread_mutex_unlock(&h->lock);
+}
+
+// Moves a tier's newest bucket up to epoch; skipped buckets hold the last value.
+// Bounded by the ring length however long the signal was silent
+static void tier_advance(struct history_series *s, int t, uint64_t epoch) {
+    if (epoch <= s->epoch[t])
+        return;
+
+    uint64_t gap = epoch - s->epoch[t];
+    if (gap > history_tiers[t].len)
+        gap = history_tiers[t].len;
+    for (uint64_t q = epoch - gap + 1; q <= epoch; q++)
+        bucket_hold(bucket_at(s, t, q), s->last);
+    s->epoch[t] = epoch;
+}
+
+void signal_history_add(struct signal_history *h, int slot, uint64_t now_us, int32_t value) {
+    if (slot < 0 || (size_t)slot >= h->count)
+        return;
+    struct history_series *s = &h->series[slot];
+
+    s->raw[s->raw_next] = (struct history_sample){.t_us = now_us, .value = value};
+    s->raw_next = (s->raw_next + 1) % HISTORY_RAW_LEN;
+    if (s->raw_count < HISTORY_RAW_LEN)
+        s->raw_count++;
+
+    for (int t = 0; t < HISTORY_TIERS; t++) {
+        uint64_t epoch = now_us / tier_width_us(t);
+        if (s->valid)
+            tier_advance(s, t, epoch);
+        else
+            s->epoch[t] = epoch;
+
+        // A held bucket keeps the held value in its range: the signal had it until now
+        struct history_bucket *b = bucket_at(s, t, epoch);
+        if (value < b->min) b->min = value;
+        if (value > b->max) b->max = value;
+        b->sum += value;
+        b->count++;
+    }
+
+    s->last  = value;
+    s->valid = 1;
+}
+
+// ============ Queries ============
+// Buckets first..last (epochs) of one tier; those after the newest are held, not stored
+static void combine(struct history_series *s, int t, uint64_t first, uint64_t last, struct history_agg *out) {
+    int64_t means = 0;
+    uint32_t known = 0;
+
+    *out = (struct history_agg){.min = INT32_MAX, .max = INT32_MIN};
+    for (uint64_t q = first; q <= last; q++) {
+        int32_t min, max, mean;
+
+        if (q > s->epoch[t]) {
+            if (!s->valid)
+                continue;
+            min = max = mean = s->last;
+        } else if (s->epoch[t] - q >= history_tiers[t].len) {
+            continue;   // recycled
+        } else {
+            const struct history_bucket *b = bucket_at(s, t, q);
+            if (b->min > b->max)
+                continue;
+            min = b->min;
+            max = b->max;
+            mean = b->count ? (int32_t)(b->sum / (int64_t)b->count) : b->min;
+            out->samples += b->count;
+        }
+
+        if (min < out->min) out->min = min;
+        if (max > out->max) out->max = max;
+        means += mean;
+        known++;
+    }
+
+    out->valid = (known > 0);
+    out->mean  = known ? (int32_t)(means / known) : 0;
+    if (!known)
+        out->min = out->max = 0;
+}
+
+// Finest tier whose ring covers the span
+static int tier_for(uint64_t span_us) {
+    for (int t = 0; t < HISTORY_TIERS; t++)
+        if (span_us <= tier_width_us(t) * history_tiers[t].len)
+            return t;
+    return -1;
+}
+
+int signal_history_window(struct signal_history *h, int slot, uint64_t now_us, uint64_t span_us,
+                          struct history_agg *out) {
+    int t = tier_for(span_us);
+    if (t < 0 || slot < 0 || (size_t)slot >= h->count)
+        return -1;
+
+    uint64_t width = tier_width_us(t);
+    uint64_t newest = now_us / width;
+    uint64_t n = (span_us + width - 1) / width;
+    if (n == 0) n = 1;
+    if (n > newest + 1) n = newest + 1;
+
+    pthread_mutex_lock(&h->lock);
+    combine(&h->series[slot], t, newest + 1 - n, newest, out);
+    pthread_mutex_unlock(&h->lock);
+    return 0;
+}
+
+int signal_history_trend(struct signal_history *h, int slot, uint64_t now_us, uint64_t span_us,
+                         struct history_agg *points, int n) {
+    int t = tier_for(span_us);
+    if (t < 0 || n <= 0 || slot < 0 || (size_t)slot >= h->count)
+        return -1;
+
+    // At least one bucket per point
+    uint64_t width = tier_width_us(t);
+    uint64_t newest = now_us / width;
+    uint64_t total = (span_us + width - 1) / width;
+    if (total < (uint64_t)n) total = n;
+    if (total > history_tiers[t].len) total = history_tiers[t].len;
+    if (total > newest + 1) total = newest + 1;
+    uint64_t first = newest + 1 - total;
+
+    pthread_mutex_lock(&h->lock);
+    for (int i = 0; i < n; i++) {
+        uint64_t q0 = first + total * i / n, q1 = first + total * (i + 1) / n;
+        if (q1 > q0)
+            combine(&h->series[slot], t, q0, q1 - 1, &points[i]);
+        else
+            points[i] = (struct history_agg){0};
+    }
+    pthread_mutex_unlock(&h->lock);
+    return 0;
+}
+
+int signal_history_raw(struct signal_history *h, int slot, struct history_sample *out, int n) {
+    if (slot < 0 || (size_t)slot >= h->count)
+        return 0;
+
+    pthread_mutex_lock(&h->lock);
+    struct history_series *s = &h->series[slot];
+    int copied = (n < (int)s->raw_count) ? n : (int)s->raw_count;
+    for (int i = 0; i < copied; i++)
+        out[i] = s->raw[(s->raw_next + HISTORY_RAW_LEN - 1 - i) % HISTORY_RAW_LEN];
+    pthread_mutex_unlock(&h->lock);
+    return copied;
+}
@@ -0,0 +1,103 @@
+#ifndef SIGNAL_HISTORY_H
+#define SIGNAL_HISTORY_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Fixed-memory time series per signal slot.
+ *
+ * Every received value goes into a raw ring (newest HISTORY_RAW_LEN
+ * samples with their times) and into the current bucket of each tier:
+ *
+ *   tier 0   1 s buckets x 120   (2 min)
+ *   tier 1  10 s buckets x 180   (30 min)
+ *   tier 2  60 s buckets x 240   (4 h)
+ *
+ * A bucket keeps min / max / sum / count, so an update is O(1) per tier.
+ * Time moving on recycles the oldest bucket; buckets that saw no sample
+ * hold the last value (signals are published on change, so silence
+ * means unchanged). Memory is allocated once and never grows.
+ *
+ * Window queries and trends combine the buckets of the finest tier that
+ * covers the span (at most one tier's worth), never raw samples. Means
+ * are averages of bucket means, i.e. time-weighted at bucket resolution.
+ *
+ * Values are raw signal units. The receive path adds a whole burst
+ * under one lock; readers take it for the duration of a query.
+ *
+ *   signal_history_begin(&h);
+ *   signal_history_add(&h, slot, now_us, raw);
+ *   signal_history_end(&h);
+ *
+ *   struct history_agg last5;
+ *   signal_history_window(&h, slot, now_us, 5 * 60 * 1000000ull, &last5);
+ */
+
+#define HISTORY_RAW_LEN  128
+#define HISTORY_TIERS    3
+
+struct history_sample {
+    uint64_t t_us;
+    int32_t  value;
+};
+
+struct history_bucket {
+    int32_t  min, max;          // min > max: nothing known yet
+    int64_t  sum;
+    uint32_t count;             // 0: held from the previous bucket, mean = min
+};
+
+struct history_tier_def {
+    uint32_t width_ms;
+    uint32_t len;
+};
+
+extern const struct history_tier_def history_tiers[HISTORY_TIERS];
+
+#define HISTORY_BUCKETS  (120 + 180 + 240)
+
+struct history_series {
+    struct history_sample raw[HISTORY_RAW_LEN];
+    uint32_t raw_next, raw_count;
+
+    struct history_bucket bucket[HISTORY_BUCKETS];    // tier rings back to back
+    uint64_t epoch[HISTORY_TIERS];                     // bucket index (time / width) of each tier's newest
+    int32_t  last;
+    uint8_t  valid;
+};
+
+// Result of a window query or one trend point
+struct history_agg {
+    int32_t  min, max, mean;
+    uint32_t samples;           // raw samples that arrived in the span
+    uint8_t  valid;             // 0 if nothing was known in the span
+};
+
+struct signal_history {
+    pthread_mutex_t lock;
+    struct history_series *series;
+    size_t count;
+};
+
+int  signal_history_init(struct signal_history *h, size_t count);
+void signal_history_free(struct signal_history *h);
+
+// Writers bracket a burst of signal_history_add() calls
+void signal_history_begin(struct signal_history *h);
+void signal_history_end(struct signal_history *h);
+void signal_history_add(struct signal_history *h, int slot, uint64_t now_us, int32_t value);
+
+// Aggregate of the last span_us; 0, or -1 if the span is longer than the coarsest tier
+int signal_history_window(struct signal_history *h, int slot, uint64_t now_us, uint64_t span_us,
+                          struct history_agg *out);
+
+// The last span_us in n equal points, oldest first (sparklines); same return
+int signal_history_trend(struct signal_history *h, int slot, uint64_t now_us, uint64_t span_us,
+                         struct history_agg *points, int n);
+
+// Newest samples, newest first; returns how many were copied
+int signal_history_raw(struct signal_history *h, int slot, struct history_sample *out, int n);
+
+#endif
@@ -0,0 +1,69 @@
+#include <stdlib.h>
+#include "signal_watch.h"
+
+// ============ Setup ============
+int signal_watch_init(struct signal_watch *w, size_t count, signal_watch_cb cb, void *ctx) {
+    w->entries = calloc(count, sizeof(*w->entries));
+    w->changed = calloc(count, sizeof(*w->changed));
+    if (!w->entries || !w->changed) {
+        signal_watch_free(w);
+        return -1;
+    }
+
+    w->count     = count;
+    w->n_changed = 0;
+    w->cb        = cb;
+    w->ctx       = ctx;
+    return 0;
+}
+
+void signal_watch_free(struct signal_watch *w) {
+    free(w->entries);
+    free(w->changed);
+    w->entries = NULL;
+    w->changed = NULL;
+    w->count   = 0;
+}
+
+void signal_watch_set_deadband(struct signal_watch *w, int slot, int64_t deadband) {
+    if (slot >= 0 && (size_t)slot < w->count)
+        w->entries[slot].deadband = (deadband > 0) ? deadband : 0;
+}
+
+// ============ Update / Flush ============
+// O(1): remember the newest value, queue the slot once per burst
+void signal_watch_update(struct signal_watch *w, int slot, int64_t value) {
+    if (slot < 0 || (size_t)slot >= w->count)
+        return;
+
+    struct signal_watch_entry *e = &w->entries[slot];
+    e->pending = value;
+    if (!e->queued) {
+        e->queued = 1;
+        w->changed[w->n_changed++] = (uint16_t)slot;
+    }
+}
+
+size_t signal_watch_flush(struct signal_watch *w) {
+    size_t published = 0;
+
+    for (size_t i = 0; i < w->n_changed; i++) {
+        struct signal_watch_entry *e = &w->entries[w->changed[i]];
+        int64_t delta = e->pending - e->value;
+
+        e->queued = 0;
+        if (e->valid && delta <= e->deadband && -delta <= e->deadband)
+            continue;
+
+        int64_t previous = e->value;
+        e->value = e->pending;
+        e->valid = 1;
+        published++;
+
+        if (w->cb)
+            w->cb(w->changed[i], e->value, previous, w->ctx);
+    }
+
+    w->n_changed = 0;
+    return published;
+}
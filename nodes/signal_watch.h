@@ -0,0 +1,39 @@
+#ifndef SIGNAL_WATCH_H
+#define SIGNAL_WATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Publish-on-change layer between decode and the application.
+ * Decoders call signal_watch_update() for every received value; at the end
+ * of a receive burst signal_watch_flush() fires the callback once for each
+ * signal whose value moved by more than its deadband since it was last
+ * published. Values are raw (unscaled) signal units.
+ */
+typedef void (*signal_watch_cb)(int slot, int64_t value, int64_t previous, void *ctx);
+
+struct signal_watch_entry {
+    int64_t value;     // last published value
+    int64_t pending;   // latest value seen in the current burst
+    int64_t deadband;  // change must exceed this to be published
+    uint8_t valid;     // value has been published at least once
+    uint8_t queued;    // slot is on the changed list
+};
+
+struct signal_watch {
+    struct signal_watch_entry *entries;
+    uint16_t *changed;
+    size_t count;
+    size_t n_changed;
+    signal_watch_cb cb;
+    void *ctx;
+};
+
+int    signal_watch_init(struct signal_watch *w, size_t count, signal_watch_cb cb, void *ctx);
+void   signal_watch_free(struct signal_watch *w);
+void   signal_watch_set_deadband(struct signal_watch *w, int slot, int64_t deadband);
+void   signal_watch_update(struct signal_watch *w, int slot, int64_t value);
+size_t signal_watch_flush(struct signal_watch *w);
+
+#endif
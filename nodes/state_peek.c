@@ -0,0 +1,118 @@
+/*
+ * state_peek - Shared memory vehicle state reader
+ * Maps the dashboard's state page read-only and prints consistent
+ * snapshots; reads are plain loads, no syscalls.
+ *
+ *   state_peek                  (one snapshot)
+ *   state_peek -w 10            (print every change, polling every 10 ms)
+ *   state_peek -b 10000000      (read throughput)
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "vehicle_state.h"
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-m name] [-w poll_ms | -b reads]\n", prog);
+    fprintf(stderr, "  -m  shared memory page (default %s)\n", VS_PAGE_NAME);
+    fprintf(stderr, "  -w  print the state whenever it changes\n");
+    fprintf(stderr, "  -b  benchmark snapshot reads\n");
+}
+
+// The page outlives a writer that crashed; a live one has a pid that still exists
+static int writer_alive(const struct vehicle_state_page *page) {
+    pid_t pid = page->writer_pid;
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+static void print_state(uint32_t seq, const struct vehicle_state *vs) {
+    printf("seq %-8u ind %d%d head %d engine %d door %d belt %d  sensors",
+           seq, vs->left_ind, vs->right_ind, vs->headlight, vs->engine, vs->door, vs->seatbelt);
+    for (uint32_t slot = 0; slot < vs->n_slots; slot++)
+        printf(" %d", vs->sensor[slot].raw);
+    if (vs->alarms)
+        printf("  alarms 0x%x", vs->alarms);
+    const char *sep = "  stale ";
+    for (uint32_t slot = 0; slot < vs->n_slots; slot++) {
+        if (vs->sensor[slot].stale) {
+            printf("%s%u", sep, slot);
+            sep = ",";
+        }
+    }
+    if (vs->notice[0])
+        printf("  \"%s\"", vs->notice);
+    printf("\n");
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    const char *name = VS_PAGE_NAME;
+    long poll_ms = -1, reads = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "m:w:b:")) != -1) {
+        if (opt == 'm')
+            name = optarg;
+        else if (opt == 'w' && atol(optarg) > 0)
+            poll_ms = atol(optarg);
+        else if (opt == 'b' && atol(optarg) > 0)
+            reads = atol(optarg);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const struct vehicle_state_page *page = vehicle_state_page_open(name);
+    if (page == NULL)
+        return 1;
+
+    struct vehicle_state *vs = vehicle_state_alloc(page->pub.state.n_slots);
+    uint32_t seq, last = 1;     // odd: never a published sequence
+
+    if (vs == NULL) {
+        perror("snapshot");
+        vehicle_state_page_close(page);
+        return 1;
+    }
+
+    if (reads > 0) {
+        double start = now_sec();
+        for (long i = 0; i < reads; i++)
+            vehicle_state_try_read(&page->pub, vs, &seq);
+        double elapsed = now_sec() - start;
+        printf("%ld reads in %.3f s: %.1f ns per snapshot, %.1f M/s\n",
+               reads, elapsed, elapsed * 1e9 / reads, reads / elapsed / 1e6);
+    }
+
+    do {
+        // Liveness only costs a syscall while nothing changes
+        if (vehicle_state_try_read(&page->pub, vs, &seq) < 0 || (seq == last && !writer_alive(page))) {
+            fprintf(stderr, "%s: writer gone\n", name);
+            vehicle_state_page_close(page);
+            free(vs);
+            return 1;
+        }
+
+        if (reads == 0 && seq != last)
+            print_state(seq, vs);
+        last = seq;
+
+        if (poll_ms > 0)
+            usleep(poll_ms * 1000);
+    } while (poll_ms > 0);
+
+    vehicle_state_page_close(page);
+    free(vs);
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * state_proto.c - Vehicle state snapshot / delta encoding
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "state_proto.h"
+
+static const size_t flag_offset[SF_FLAG_COUNT] = {
+    [SF_LEFT_IND]  = offsetof(struct vehicle_state, left_ind),
+    [SF_RIGHT_IND] = offsetof(struct vehicle_state, right_ind),
+    [SF_HEADLIGHT] = offsetof(struct vehicle_state, headlight),
+    [SF_ENGINE]    = offsetof(struct vehicle_state, engine),
+    [SF_DOOR]      = offsetof(struct vehicle_state, door),
+    [SF_SEATBELT]  = offsetof(struct vehicle_state, seatbelt),
+};
+
+#define SENSOR_LEN  (1 + 2 + 4 + 1)  // id, slot, raw, stale
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t state_msg_max(uint32_t n_slots) {
+    return SS_HEADER_LEN + 3 + 2 * SF_FLAG_COUNT + (size_t)SENSOR_LEN * n_slots + 1 + VS_NOTICE_LEN + 5;
+}
+
+static size_t put_sensor(uint8_t *out, const struct vehicle_state *vs, uint32_t slot) {
+    out[0] = SF_SENSOR;
+    put_u16(&out[1], slot);
+    put_u32(&out[3], (uint32_t)vs->sensor[slot].raw);
+    out[7] = vs->sensor[slot].stale;
+    return SENSOR_LEN;
+}
+
+size_t state_encode(uint8_t type, uint32_t seq, const struct vehicle_state *prev,
+                    const struct vehicle_state *cur, const uint64_t *changed, uint8_t *out) {
+    size_t n = SS_HEADER_LEN;
+
+    out[0] = type;
+    put_u32(&out[1], seq);
+
+    if (prev == NULL) {
+        out[n++] = SF_SLOTS;
+        put_u16(&out[n], cur->n_slots);
+        n += 2;
+    }
+
+    for (int f = 0; f < SF_FLAG_COUNT; f++) {
+        uint8_t v = *((const uint8_t *)cur + flag_offset[f]);
+        if (prev == NULL || v != *((const uint8_t *)prev + flag_offset[f])) {
+            out[n++] = f;
+            out[n++] = v;
+        }
+    }
+
+    // Written slots go as they are: one written after prev was taken may already be in it
+    if (prev != NULL && changed != NULL) {
+        for (uint32_t word = 0; word < (cur->n_slots + 63u) / 64; word++)
+            for (uint64_t bits = changed[word]; bits; bits &= bits - 1)
+                n += put_sensor(&out[n], cur, word * 64 + __builtin_ctzll(bits));
+    } else {
+        for (uint32_t slot = 0; slot < cur->n_slots; slot++)
+            if (prev == NULL || cur->sensor[slot].raw != prev->sensor[slot].raw ||
+                cur->sensor[slot].stale != prev->sensor[slot].stale)
+                n += put_sensor(&out[n], cur, slot);
+    }
+
+    size_t len = strnlen(cur->notice, VS_NOTICE_LEN - 1);
+    if (prev == NULL || strncmp(cur->notice, prev->notice, VS_NOTICE_LEN) != 0) {
+        out[n++] = SF_NOTICE;
+        out[n++] = len;
+        memcpy(&out[n], cur->notice, len);
+        n += len;
+    }
+
+    if (prev == NULL || cur->alarms != prev->alarms) {
+        out[n++] = SF_ALARMS;
+        put_u32(&out[n], cur->alarms);
+        n += 4;
+    }
+
+    return (n == SS_HEADER_LEN && prev != NULL) ? 0 : n;
+}
+
+int state_slots(const uint8_t *msg, size_t len) {
+    if (len < SS_HEADER_LEN + 3 || msg[0] != SS_MSG_SNAPSHOT || msg[SS_HEADER_LEN] != SF_SLOTS)
+        return -1;
+    return get_u16(&msg[SS_HEADER_LEN + 1]);
+}
+
+int state_decode(const uint8_t *msg, size_t len, struct vehicle_state *vs, uint32_t *seq) {
+    int fields = 0;
+
+    if (len < SS_HEADER_LEN || (msg[0] != SS_MSG_SNAPSHOT && msg[0] != SS_MSG_DELTA))
+        return -1;
+    *seq = get_u32(&msg[1]);
+
+    for (size_t n = SS_HEADER_LEN; n < len; fields++) {
+        uint8_t f = msg[n++];
+
+        if (f < SF_FLAG_COUNT) {
+            if (n + 1 > len) return -1;
+            *((uint8_t *)vs + flag_offset[f]) = msg[n++];
+        } else if (f == SF_SLOTS) {
+            if (n + 2 > len || get_u16(&msg[n]) != vs->n_slots) return -1;
+            n += 2;
+        } else if (f == SF_SENSOR) {
+            if (n + SENSOR_LEN - 1 > len || get_u16(&msg[n]) >= vs->n_slots) return -1;
+            struct vehicle_sensor *s = &vs->sensor[get_u16(&msg[n])];
+            s->raw   = (int32_t)get_u32(&msg[n + 2]);
+            s->stale = msg[n + 6];
+            n += SENSOR_LEN - 1;
+        } else if (f == SF_NOTICE) {
+            if (n + 1 > len || n + 1 + msg[n] > len || msg[n] >= VS_NOTICE_LEN) return -1;
+            memcpy(vs->notice, &msg[n + 1], msg[n]);
+            vs->notice[msg[n]] = '\0';
+            n += 1 + msg[n];
+        } else if (f == SF_ALARMS) {
+            if (n + 4 > len) return -1;
+            vs->alarms = get_u32(&msg[n]);
+            n += 4;
+        } else
+            return -1;
+    }
+    return fields;
+}
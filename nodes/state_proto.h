@@ -0,0 +1,80 @@
+#ifndef STATE_PROTO_H
+#define STATE_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vehicle_state.h"
+
+/*
+ * Vehicle state wire format, for the dashboard daemon's Unix socket.
+ *
+ * SOCK_SEQPACKET, so every message is one packet and needs no framing.
+ * Multi-byte values are little-endian.
+ *
+ *   server -> client   u8 type, u32 seq, then fields
+ *     SS_MSG_SNAPSHOT  every field, SF_SLOTS first; sent on connect and after falling behind
+ *     SS_MSG_DELTA     only the fields that changed since the previous message
+ *
+ *   field              u8 id, then the value:
+ *     SF_SLOTS                        u16, sensor slots of the state
+ *     SF_LEFT_IND .. SF_SEATBELT      u8
+ *     SF_SENSOR                       u16 slot, i32 raw signal units (scaled by the signal
+ *                                     database), u8 1 if its message missed its deadline
+ *     SF_NOTICE                       u8 length, text (not terminated)
+ *     SF_ALARMS                       u32, active alarm rules (bit per rule)
+ *
+ *   client -> server   u8 SS_MSG_COMMAND, u8 menu option
+ *   server -> client   u8 SS_MSG_ACK, u8 option, u8 status (0 = accepted)
+ *
+ * seq counts published states; a client that applies a snapshot and then
+ * every delta in order holds exactly the published state. Slots are the
+ * signal database's, so the size of a snapshot follows the database:
+ * clients size their state from SF_SLOTS and their buffer from the packet.
+ */
+
+#define SS_DEFAULT_SOCKET  "/tmp/dashboard.sock"
+#define SS_COMMAND_LEN   2
+
+// Message types
+#define SS_MSG_SNAPSHOT  1
+#define SS_MSG_DELTA     2
+#define SS_MSG_COMMAND   3
+#define SS_MSG_ACK       4
+
+#define SS_HEADER_LEN    5      // type + seq
+
+// Field ids
+#define SF_LEFT_IND      0x00
+#define SF_RIGHT_IND     0x01
+#define SF_HEADLIGHT     0x02
+#define SF_ENGINE        0x03
+#define SF_DOOR          0x04
+#define SF_SEATBELT      0x05
+#define SF_FLAG_COUNT    6
+#define SF_SLOTS         0x10
+#define SF_SENSOR        0x11
+#define SF_NOTICE        0x20
+#define SF_ALARMS        0x30
+
+// SS_MSG_ACK status
+#define SS_ACK_OK        0
+#define SS_ACK_REJECTED  1
+
+// Longest message for a state with n_slots sensors
+size_t state_msg_max(uint32_t n_slots);
+
+// Encodes the fields of cur that differ from prev (all of them if prev is NULL) after the
+// header into out, of state_msg_max(cur->n_slots) bytes. Given changed, a bitmap of the
+// slots written since prev, a delta carries those sensors without comparing the rest.
+// Returns the message length, or 0 if a delta would be empty
+size_t state_encode(uint8_t type, uint32_t seq, const struct vehicle_state *prev,
+                    const struct vehicle_state *cur, const uint64_t *changed, uint8_t *out);
+
+// Sensor slots a snapshot announces; -1 if msg is not a well-formed snapshot
+int state_slots(const uint8_t *msg, size_t len);
+
+// Applies a snapshot or delta to vs, allocated for the announced slots; returns the
+// number of fields, -1 if malformed
+int state_decode(const uint8_t *msg, size_t len, struct vehicle_state *vs, uint32_t *seq);
+
+#endif
@@ -0,0 +1,205 @@
+/*
+ * state_server.c - Vehicle state snapshots and deltas over a Unix socket
+ */
+
+#define _GNU_SOURCE     // accept4
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "state_server.h"
+
+#define SS_EVENTS  16
+
+// Listening socket's epoll data; clients carry their slot index
+#define SS_LISTENER  UINT32_MAX
+
+static void client_drop(struct state_server *srv, struct state_client *c) {
+    epoll_ctl(srv->fd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    srv->n_clients--;
+}
+
+// Non-blocking: a full socket marks the client as behind and waits for EPOLLOUT
+static void client_send(struct state_server *srv, struct state_client *c, const uint8_t *msg, size_t len) {
+    if (send(c->fd, msg, len, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)len) {
+        srv->sent++;
+        return;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        client_drop(srv, c);
+        return;
+    }
+
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLOUT, .data.u32 = c - srv->clients};
+    epoll_ctl(srv->fd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->behind = 1;
+    srv->skipped++;
+}
+
+static void client_snapshot(struct state_server *srv, struct state_client *c) {
+    size_t len = state_encode(SS_MSG_SNAPSHOT, srv->seq, NULL, srv->last, NULL, srv->msg);
+
+    if (c->behind) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = c - srv->clients};
+        epoll_ctl(srv->fd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->behind = 0;
+    }
+    client_send(srv, c, srv->msg, len);
+}
+
+static void client_accept(struct state_server *srv) {
+    int fd;
+
+    while ((fd = accept4(srv->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+        struct state_client *c = NULL;
+        for (int i = 0; i < SS_MAX_CLIENTS && c == NULL; i++)
+            if (srv->clients[i].fd < 0)
+                c = &srv->clients[i];
+
+        struct epoll_event ev = {.events = EPOLLIN};
+        if (c != NULL) {
+            ev.data.u32 = c - srv->clients;
+            c->fd = fd;
+            c->behind = 0;
+        }
+        if (c == NULL || epoll_ctl(srv->fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);  // full
+            if (c != NULL)
+                c->fd = -1;
+            continue;
+        }
+        srv->n_clients++;
+        client_snapshot(srv, c);
+    }
+}
+
+static void client_readable(struct state_server *srv, struct state_client *c, uint64_t now_us) {
+    uint8_t msg[SS_COMMAND_LEN + 1];
+    ssize_t n;
+
+    while ((n = recv(c->fd, msg, sizeof(msg), MSG_DONTWAIT)) > 0) {
+        if (n != SS_COMMAND_LEN || msg[0] != SS_MSG_COMMAND)
+            continue;   // not ours, ignored
+
+        uint8_t ack[3] = {SS_MSG_ACK, msg[1], srv->command(msg[1], now_us, srv->ctx)};
+        srv->commands++;
+        client_send(srv, c, ack, sizeof(ack));
+        if (c->fd < 0)
+            return;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        client_drop(srv, c);
+}
+
+// ============ Public ============
+int state_server_init(struct state_server *srv, const char *path, uint32_t n_slots,
+                      state_command_cb command, void *ctx) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+
+    memset(srv, 0, sizeof(*srv));
+    for (int i = 0; i < SS_MAX_CLIENTS; i++)
+        srv->clients[i].fd = -1;
+    srv->path    = path;
+    srv->command = command;
+    srv->ctx     = ctx;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "State socket path too long: %s\n", path);
+        return -1;
+    }
+
+    strcpy(addr.sun_path, path);
+
+    srv->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (srv->listen_fd < 0) {
+        perror("State socket creation failed");
+        return -1;
+    }
+
+    unlink(path);   // left behind by a previous run
+    if (bind(srv->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(srv->listen_fd, SS_BACKLOG) < 0) {
+        perror("State socket bind failed");
+        close(srv->listen_fd);
+        return -1;
+    }
+
+    srv->fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = SS_LISTENER};
+    if (srv->fd < 0 || epoll_ctl(srv->fd, EPOLL_CTL_ADD, srv->listen_fd, &ev) < 0) {
+        perror("State socket epoll failed");
+        close(srv->listen_fd);
+        unlink(path);
+        return -1;
+    }
+
+    // Messages grow with the database's slots
+    srv->last = vehicle_state_alloc(n_slots);
+    srv->msg  = malloc(state_msg_max(n_slots));
+    if (srv->last == NULL || srv->msg == NULL) {
+        perror("State socket buffers");
+        state_server_close(srv);
+        return -1;
+    }
+    return 0;
+}
+
+void state_server_close(struct state_server *srv) {
+    for (int i = 0; i < SS_MAX_CLIENTS; i++)
+        if (srv->clients[i].fd >= 0)
+            client_drop(srv, &srv->clients[i]);
+    close(srv->listen_fd);
+    close(srv->fd);
+    unlink(srv->path);
+    free(srv->last);
+    free(srv->msg);
+    srv->last = NULL;
+    srv->msg = NULL;
+}
+
+void state_server_process(struct state_server *srv, uint64_t now_us) {
+    struct epoll_event events[SS_EVENTS];
+    int n = epoll_wait(srv->fd, events, SS_EVENTS, 0);
+
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.u32 == SS_LISTENER) {
+            client_accept(srv);
+            continue;
+        }
+
+        struct state_client *c = &srv->clients[events[i].data.u32];
+        if (c->fd < 0)
+            continue;   // dropped earlier in this batch
+        // Commands sent just before hanging up are still taken; reading the end drops the client
+        if (events[i].events & EPOLLIN)
+            client_readable(srv, c, now_us);
+        else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            client_drop(srv, c);
+            continue;
+        }
+        if (c->fd >= 0 && c->behind && (events[i].events & EPOLLOUT))
+            client_snapshot(srv, c);
+    }
+}
+
+void state_server_publish(struct state_server *srv, const struct vehicle_state *vs, const uint64_t *changed) {
+    size_t len = state_encode(SS_MSG_DELTA, srv->seq + 1, srv->last, vs, changed, srv->msg);
+
+    if (len == 0)
+        return;
+    srv->seq++;
+    srv->published++;
+    memcpy(srv->last, vs, vehicle_state_size(srv->last->n_slots));
+
+    for (int i = 0; i < SS_MAX_CLIENTS; i++) {
+        struct state_client *c = &srv->clients[i];
+        if (c->fd >= 0 && !c->behind)
+            client_send(srv, c, srv->msg, len);
+    }
+}
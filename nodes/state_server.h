@@ -0,0 +1,68 @@
+#ifndef STATE_SERVER_H
+#define STATE_SERVER_H
+
+#include <stdint.h>
+#include "state_proto.h"
+
+/*
+ * Vehicle state over a Unix socket (wire format in state_proto.h).
+ *
+ * A client gets a snapshot when it connects, then a delta for every
+ * published change. Each delta is encoded once and the same packet goes
+ * to every client with a non-blocking send. A client whose socket is
+ * full is not queued for: it skips deltas until it is writable again and
+ * then gets a fresh snapshot, so a slow reader costs nothing and never
+ * holds back the others.
+ *
+ * The server's sockets sit in its own epoll instance; the caller watches
+ * state_server.fd with whatever loop it runs and calls
+ * state_server_process() when it is readable.
+ *
+ *   state_server_init(&srv, "/tmp/dashboard.sock", n_slots, on_command, NULL);
+ *   ... srv.fd readable:  state_server_process(&srv, now_us);
+ *   ... state changed:    state_server_publish(&srv, vs, changed);
+ */
+
+#define SS_MAX_CLIENTS  64
+#define SS_BACKLOG      16
+
+// Menu option from a client; returns SS_ACK_OK or SS_ACK_REJECTED
+typedef int (*state_command_cb)(int option, uint64_t rx_us, void *ctx);
+
+struct state_client {
+    int fd;                     // -1 if the slot is free
+    uint8_t behind;             // missed a delta, waiting to be writable for a snapshot
+};
+
+struct state_server {
+    int fd;                     // epoll instance, readable when there is work
+    int listen_fd;
+    const char *path;
+    struct state_client clients[SS_MAX_CLIENTS];
+    int n_clients;
+
+    struct vehicle_state *last; // last published state
+    uint8_t *msg;               // encode buffer, state_msg_max() of it
+    uint32_t seq;
+
+    state_command_cb command;
+    void *ctx;
+
+    // Totals
+    uint64_t published, sent, skipped, commands;
+};
+
+// Binds path (replacing a stale socket file) for states of n_slots sensors; -1 after
+// printing the reason
+int  state_server_init(struct state_server *srv, const char *path, uint32_t n_slots,
+                       state_command_cb command, void *ctx);
+void state_server_close(struct state_server *srv);
+
+// Accepts clients, reads commands, resynchronises clients that fell behind
+void state_server_process(struct state_server *srv, uint64_t now_us);
+
+// Sends the delta from the last published state to every client that is keeping up;
+// changed (NULL: compare them all) are the slots written since, as for state_encode()
+void state_server_publish(struct state_server *srv, const struct vehicle_state *vs, const uint64_t *changed);
+
+#endif
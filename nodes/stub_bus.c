@@ -0,0 +1,324 @@
+/*
+ * stub_bus.c - In-process stand-in for the CAN bus
+ * Linked into the *_stub dashboards in place of can_utils.c, so they run
+ * without SocketCAN: every initialize_can_socket() returns one end of a
+ * socketpair and threads here play the other nodes.
+ *
+ *   first socket (sensors, commands)
+ *       coolant 0x080 every STUB_COOLANT_MS (20), tyre 0x099 every
+ *       STUB_TYRE_MS (100), engine data 0x090 every STUB_ENGINE_MS (10),
+ *       or the frames of STUB_LOG (struct can_frame records) one every
+ *       STUB_LOG_US (1000) instead; 0 disables a message. Every frame
+ *       written to it comes back after STUB_ECHO_US (250), BCM and engine
+ *       commands flagged MSG_CONFIRM like a CAN_RAW_RECV_OWN_MSGS echo.
+ *       With STUB_E2E_COUNTER=n the BCM and engine check those commands
+ *       as the nodes do, starting synced at counter n (nodes that kept
+ *       running across a dashboard restart), and answer each rejection
+ *       with an E2E_REPORT_CAN_ID frame.
+ *   second socket (door / seat belt status)
+ *       an RTR is answered "closed" / "fastened" after STUB_DOOR_US /
+ *       STUB_BELT_US (2000), plus up to STUB_JITTER_US (0) at random; the
+ *       seat belt stops answering after STUB_BELT_ANSWERS requests.
+ *
+ * STUB_VERBOSE=1 logs every RTR to stderr. Examples:
+ *
+ *   ./dashboard_reactor_stub                        (type 7, 8, 0)
+ *   STUB_DOOR_US=300000 STUB_BELT_US=400000 ./dashboard_thread_stub
+ *   STUB_BELT_ANSWERS=1 ./dashboard_reactor_stub -l 0   (second start times out)
+ *   STUB_LOG=frames.log STUB_LOG_US=100 ./dashboard_reactor_stub -m /stub
+ *   STUB_E2E_COUNTER=100 STUB_VERBOSE=1 ./dashboard_reactor_stub
+ *
+ * recvmsg is wrapped (-Wl,--wrap=recvmsg) to set MSG_CONFIRM and setsockopt
+ * to accept the SOL_CAN_RAW options; a socketpair has no SO_TIMESTAMP, so
+ * the dashboards fall back to their own clock.
+ */
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "can_header.h"
+#include "can_utils.h"
+#include "e2e.h"
+
+#define STUB_SOCKETS 2
+
+static int dash_fd[STUB_SOCKETS] = {-1, -1};   // the dashboard's ends
+static int node_fd[STUB_SOCKETS];              // ours
+static int n_sockets;
+
+static double start_s;
+static int verbose;
+static int belt_answers_left = -1;             // -1: always answer
+static pthread_mutex_t belt_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long env_long(const char *name, long fallback) {
+    const char *v = getenv(name);
+    return (v && *v) ? strtol(v, NULL, 0) : fallback;
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+// ============ Sensor Nodes ============
+// Values in signals.db units: coolant 0.01 °C, tyre Pa, rpm, battery mV
+static void make_frame(struct can_frame *f, uint32_t id, long tick) {
+    memset(f, 0, sizeof(*f));
+    f->can_id  = id;
+    f->can_dlc = 8;
+
+    if (id == COOLANT_CAN_ID) {
+        put_be32(f->data, 9000 + rand() % 601 - 300);
+    } else if (id == TYRE_PR_CAN_ID) {
+        put_be32(f->data, 220000 + rand() % 2001 - 1000);
+    } else {
+        int rpm = 850 + (int)(600 * sin(tick / 50.0)) + rand() % 21 - 10;
+        int mv  = 14100 + rand() % 41 - 20;
+        f->data[0] = rpm >> 8;
+        f->data[1] = rpm;
+        f->data[2] = mv >> 8;
+        f->data[3] = mv;
+    }
+}
+
+static void *replay(void *arg) {
+    const char *path = arg;
+    long period_us = env_long("STUB_LOG_US", 1000);
+    FILE *log = fopen(path, "rb");
+    struct can_frame f;
+
+    if (log == NULL) {
+        perror("stub: log open failed");
+        return NULL;
+    }
+    while (fread(&f, sizeof(f), 1, log) == 1) {
+        if (write(node_fd[0], &f, sizeof(f)) != sizeof(f))
+            break;
+        usleep(period_us);
+    }
+    fclose(log);
+    return NULL;
+}
+
+// One tick per millisecond; each message goes out when its period comes round
+static void *sensors(void *arg) {
+    (void)arg;
+    const uint32_t ids[3] = {COOLANT_CAN_ID, TYRE_PR_CAN_ID, ENGINE_DATA_CAN_ID};
+    const long period[3] = {
+        env_long("STUB_COOLANT_MS", 20), env_long("STUB_TYRE_MS", 100), env_long("STUB_ENGINE_MS", 10),
+    };
+    struct can_frame f;
+
+    for (long tick = 0;; tick++) {
+        for (int i = 0; i < 3; i++) {
+            if (period[i] <= 0 || tick % period[i] != 0)
+                continue;
+            make_frame(&f, ids[i], tick / period[i]);
+            if (write(node_fd[0], &f, sizeof(f)) != sizeof(f))
+                return NULL;
+        }
+        usleep(1000);
+    }
+}
+
+// ============ Echo ============
+struct delayed {
+    int fd;
+    long delay_us;
+    struct can_frame frame;
+};
+
+static void *send_later(void *arg) {
+    struct delayed *d = arg;
+    usleep(d->delay_us);
+    if (write(d->fd, &d->frame, sizeof(d->frame)) != sizeof(d->frame))
+        perror("stub: write failed");
+    free(d);
+    return NULL;
+}
+
+static void schedule(int fd, const struct can_frame *frame, long delay_us) {
+    struct delayed *d = malloc(sizeof(*d));
+    pthread_t t;
+
+    if (d == NULL)
+        return;
+    *d = (struct delayed){fd, delay_us, *frame};
+    if (pthread_create(&t, NULL, send_later, d) != 0) {
+        free(d);
+        return;
+    }
+    pthread_detach(t);
+}
+
+// ============ BCM / Engine Nodes ============
+struct receiver {
+    uint32_t can_id;
+    struct e2e_rx_state rx;
+    uint8_t state;              // lamp word, or 1 if the engine runs
+};
+
+static struct receiver receivers[2] = {{.can_id = BCM_CAN_ID}, {.can_id = ENGINE_CAN_ID}};
+static int check_commands;
+
+// The BCM checks command words and sync frames only, the engine every frame
+static void receive_command(const struct can_frame *f, long delay_us) {
+    for (int i = 0; i < 2; i++) {
+        struct receiver *r = &receivers[i];
+        if (f->can_id != r->can_id)
+            continue;
+        if (r->can_id == BCM_CAN_ID && f->data[0] != BCM_CMD_WORD && f->data[0] != E2E_SYNC)
+            return;
+
+        const struct e2e_profile *p = e2e_profile_lookup(r->can_id);
+        int err = e2e_check(p, &r->rx, f->data, f->can_dlc);
+        if (verbose)
+            fprintf(stderr, "[stub %8.1f ms] 0x%03X counter %u: %s\n", (now_s() - start_s) * 1e3,
+                    r->can_id, f->data[p->data_len], e2e_strerror(err));
+        if (err == E2E_OK && r->can_id == BCM_CAN_ID)
+            r->state = (r->state & ~f->data[2]) | (f->data[1] & f->data[2]);
+        else if (err == E2E_OK)
+            r->state = (f->data[0] == EN_ON);
+        if (err >= 0)
+            return;
+
+        struct can_frame report = {.can_id = E2E_REPORT_CAN_ID};
+        report.can_dlc = e2e_report_encode(p, err, f->data, f->can_dlc, r->state, report.data);
+        schedule(node_fd[0], &report, 2 * delay_us);
+        return;
+    }
+}
+
+static void *echo(void *arg) {
+    (void)arg;
+    long delay_us = env_long("STUB_ECHO_US", 250);
+    struct can_frame f;
+
+    while (read(node_fd[0], &f, sizeof(f)) == sizeof(f)) {
+        schedule(node_fd[0], &f, delay_us);
+        if (check_commands)
+            receive_command(&f, delay_us);
+    }
+    return NULL;
+}
+
+// ============ Door / Seat Belt Nodes ============
+static void *status_nodes(void *arg) {
+    (void)arg;
+    long door_us = env_long("STUB_DOOR_US", 2000), belt_us = env_long("STUB_BELT_US", 2000);
+    long jitter_us = env_long("STUB_JITTER_US", 0);
+    struct can_frame f;
+
+    while (read(node_fd[1], &f, sizeof(f)) == sizeof(f)) {
+        if (!(f.can_id & CAN_RTR_FLAG))
+            continue;
+        uint32_t id = f.can_id & CAN_SFF_MASK;
+        if (id != DOOR_CAN_ID && id != SEATBELT_CAN_ID)
+            continue;
+
+        int answer = 1;
+        if (id == SEATBELT_CAN_ID) {
+            pthread_mutex_lock(&belt_lock);
+            if (belt_answers_left == 0)
+                answer = 0;
+            else if (belt_answers_left > 0)
+                belt_answers_left--;
+            pthread_mutex_unlock(&belt_lock);
+        }
+        if (verbose)
+            fprintf(stderr, "[stub %8.1f ms] rtr 0x%03X%s\n", (now_s() - start_s) * 1e3, id,
+                    answer ? "" : " (ignored)");
+        if (!answer)
+            continue;
+
+        long base = (id == DOOR_CAN_ID) ? door_us : belt_us;
+        struct can_frame reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.can_id  = id;
+        reply.can_dlc = 1;
+        reply.data[0] = 1;
+        schedule(node_fd[1], &reply, base + (jitter_us > 0 ? rand() % (jitter_us + 1) : 0));
+    }
+    return NULL;
+}
+
+// ============ Socket Replacement ============
+ssize_t __real_recvmsg(int fd, struct msghdr *msg, int flags);
+
+ssize_t __wrap_recvmsg(int fd, struct msghdr *msg, int flags) {
+    ssize_t n = __real_recvmsg(fd, msg, flags);
+
+    if (n == sizeof(struct can_frame) && fd == dash_fd[0]) {
+        const struct can_frame *f = msg->msg_iov[0].iov_base;
+        uint32_t id = f->can_id & CAN_SFF_MASK;
+        if (id == BCM_CAN_ID || id == ENGINE_CAN_ID)
+            msg->msg_flags |= MSG_CONFIRM;
+    }
+    return n;
+}
+
+int __real_setsockopt(int fd, int level, int name, const void *value, socklen_t len);
+
+// Filters and own-message echo are the stub's business: the dashboards check ids themselves
+int __wrap_setsockopt(int fd, int level, int name, const void *value, socklen_t len) {
+    if (level == SOL_CAN_RAW)
+        return 0;
+    return __real_setsockopt(fd, level, name, value, len);
+}
+
+// Every call hands out the next socketpair: sensors and commands, then status
+int initialize_can_socket(const char *ifname, struct can_filter *filter, int filter_count) {
+    (void)ifname;
+    (void)filter;
+    (void)filter_count;
+    int sv[2];
+    pthread_t t;
+
+    if (n_sockets == STUB_SOCKETS) {
+        fprintf(stderr, "stub: only %d CAN sockets\n", STUB_SOCKETS);
+        return -1;
+    }
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        perror("stub: socketpair failed");
+        return -1;
+    }
+    dash_fd[n_sockets] = sv[0];
+    node_fd[n_sockets] = sv[1];
+
+    if (n_sockets == 0) {
+        start_s = now_s();
+        verbose = env_long("STUB_VERBOSE", 0) != 0;
+        belt_answers_left = env_long("STUB_BELT_ANSWERS", -1);
+        long counter = env_long("STUB_E2E_COUNTER", -1);
+        if (counter >= 0) {
+            check_commands = 1;
+            for (int i = 0; i < 2; i++)
+                receivers[i].rx = (struct e2e_rx_state){.last_counter = (uint8_t)counter, .synced = 1};
+        }
+        const char *log = getenv("STUB_LOG");
+        pthread_create(&t, NULL, log ? replay : sensors, (void *)log);
+        pthread_detach(t);
+        pthread_create(&t, NULL, echo, NULL);
+    } else {
+        pthread_create(&t, NULL, status_nodes, NULL);
+    }
+    pthread_detach(t);
+    return dash_fd[n_sockets++];
+}
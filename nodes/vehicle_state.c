@@ -0,0 +1,243 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "vehicle_state.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#else
+#define cpu_relax() do { } while (0)
+#endif
+
+size_t vehicle_state_size(uint32_t n_slots) {
+    return offsetof(struct vehicle_state, sensor) + (size_t)n_slots * sizeof(struct vehicle_sensor);
+}
+
+size_t vehicle_state_pub_size(uint32_t n_slots) {
+    return offsetof(struct vehicle_state_pub, state) + vehicle_state_size(n_slots);
+}
+
+struct vehicle_state *vehicle_state_alloc(uint32_t n_slots) {
+    struct vehicle_state *vs = calloc(1, vehicle_state_size(n_slots));
+
+    if (vs != NULL)
+        vs->n_slots = n_slots;
+    return vs;
+}
+
+void vehicle_state_init(struct vehicle_state_pub *pub, uint32_t n_slots) {
+    pthread_mutexattr_t attr;
+
+    memset(&pub->state, 0, vehicle_state_size(n_slots));
+    pub->state.n_slots = n_slots;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&pub->write_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    atomic_store_explicit(&pub->seq, 0, memory_order_release);
+}
+
+// Writers exclude each other with the lock; the odd sequence only tells readers
+struct vehicle_state *vehicle_state_write_begin(struct vehicle_state_pub *pub) {
+    pthread_mutex_lock(&pub->write_lock);
+    uint32_t seq = atomic_load_explicit(&pub->seq, memory_order_relaxed);
+    atomic_store_explicit(&pub->seq, seq + 1, memory_order_relaxed);
+
+    // Keep the state stores after the odd sequence becomes visible
+    atomic_thread_fence(memory_order_release);
+    return &pub->state;
+}
+
+void vehicle_state_write_end(struct vehicle_state_pub *pub) {
+    atomic_fetch_add_explicit(&pub->seq, 1, memory_order_release);
+    pthread_mutex_unlock(&pub->write_lock);
+}
+
+uint32_t vehicle_state_read(const struct vehicle_state_pub *pub, struct vehicle_state *out) {
+    uint32_t before, after;
+
+    do {
+        before = atomic_load_explicit(&pub->seq, memory_order_acquire);
+        while (before & 1) {
+            cpu_relax();
+            before = atomic_load_explicit(&pub->seq, memory_order_acquire);
+        }
+
+        memcpy(out, &pub->state, vehicle_state_size(out->n_slots));
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&pub->seq, memory_order_relaxed);
+    } while (before != after);
+
+    return before;
+}
+
+int vehicle_state_try_read(const struct vehicle_state_pub *pub, struct vehicle_state *out, uint32_t *seq) {
+    uint32_t before, after, spins = 0;
+
+    do {
+        before = atomic_load_explicit(&pub->seq, memory_order_acquire);
+        while (before & 1) {
+            if (++spins == VS_READ_SPINS)
+                return -1;
+            cpu_relax();
+            before = atomic_load_explicit(&pub->seq, memory_order_acquire);
+        }
+
+        memcpy(out, &pub->state, vehicle_state_size(out->n_slots));
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&pub->seq, memory_order_relaxed);
+    } while (before != after);
+
+    *seq = before;
+    return 0;
+}
+
+// ============ Shared Memory Page ============
+// Whole pages, so nothing else shares the mapping
+static size_t page_bytes(size_t pub_size) {
+    size_t pg = sysconf(_SC_PAGESIZE);
+    return (offsetof(struct vehicle_state_page, pub) + pub_size + pg - 1) / pg * pg;
+}
+
+static int pid_alive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// A fresh name is created exclusively. An existing page is only taken over if its
+// writer is gone; ownership moves by swapping writer_pid, so two dashboards racing
+// for a stale page cannot both win. One left for another state size is replaced by
+// a new page, so readers still mapping the old one never see it resized
+struct vehicle_state_page *vehicle_state_page_create(const char *name, uint32_t n_slots) {
+    size_t pub_size = vehicle_state_pub_size(n_slots);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    int fresh = (fd >= 0);
+    if (fd < 0 && errno == EEXIST)
+        fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        perror("Vehicle state shm_open failed");
+        return NULL;
+    }
+
+    // Not sized yet: its creator is still setting it up
+    struct stat st;
+    if (!fresh && (fstat(fd, &st) < 0 || (size_t)st.st_size < page_bytes(0))) {
+        fprintf(stderr, "%s: being created by another writer\n", name);
+        close(fd);
+        return NULL;
+    }
+    if (fresh && ftruncate(fd, page_bytes(pub_size)) < 0) {
+        perror("Vehicle state ftruncate failed");
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    // The header first: an existing page may be sized for another state
+    struct vehicle_state_page *page = mmap(NULL, page_bytes(0), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+        perror("Vehicle state mmap failed");
+        close(fd);
+        if (fresh)
+            shm_unlink(name);
+        return NULL;
+    }
+
+    _Atomic int32_t *writer = (_Atomic int32_t *)&page->writer_pid;
+    int32_t owner = atomic_load(writer);
+    if (pid_alive(owner) || !atomic_compare_exchange_strong(writer, &owner, getpid())) {
+        fprintf(stderr, "%s: in use by pid %d\n", name, (int)atomic_load(writer));
+        munmap(page, page_bytes(0));
+        close(fd);
+        return NULL;
+    }
+    if (!fresh && (page->version != VS_PAGE_VERSION || page->size != pub_size)) {
+        shm_unlink(name);
+        munmap(page, page_bytes(0));
+        close(fd);
+        return vehicle_state_page_create(name, n_slots);
+    }
+
+    struct vehicle_state_page *full = mmap(NULL, page_bytes(pub_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (full == MAP_FAILED) {
+        perror("Vehicle state mmap failed");
+        atomic_store(writer, 0);
+        munmap(page, page_bytes(0));
+        if (fresh)
+            shm_unlink(name);
+        return NULL;
+    }
+    munmap(page, page_bytes(0));
+    page = full;
+
+    // A page left by a previous run is reinitialised; readers see no magic meanwhile
+    atomic_store_explicit((_Atomic uint32_t *)&page->magic, 0, memory_order_relaxed);
+    page->version = VS_PAGE_VERSION;
+    page->size    = pub_size;
+    vehicle_state_init(&page->pub, n_slots);
+    atomic_store_explicit((_Atomic uint32_t *)&page->magic, VS_PAGE_MAGIC, memory_order_release);
+    return page;
+}
+
+const struct vehicle_state_page *vehicle_state_page_open(const char *name) {
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        perror("Vehicle state shm_open failed - is the dashboard running?");
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < page_bytes(0)) {
+        fprintf(stderr, "%s: not initialised yet\n", name);
+        close(fd);
+        return NULL;
+    }
+
+    // The header says how much state follows; the page is never resized once created
+    const struct vehicle_state_page *page = mmap(NULL, page_bytes(0), PROT_READ, MAP_SHARED, fd, 0);
+    if (page == MAP_FAILED) {
+        perror("Vehicle state mmap failed");
+        close(fd);
+        return NULL;
+    }
+
+    const struct vehicle_state_page *full = NULL;
+    if (atomic_load_explicit((const _Atomic uint32_t *)&page->magic, memory_order_acquire) != VS_PAGE_MAGIC) {
+        fprintf(stderr, "%s: not initialised yet\n", name);
+    } else if (page->version != VS_PAGE_VERSION || page->size < vehicle_state_pub_size(0) ||
+               page->size != vehicle_state_pub_size(page->pub.state.n_slots) ||
+               (size_t)st.st_size < page_bytes(page->size)) {
+        fprintf(stderr, "%s: layout version %u (%u bytes), expected %u (%zu bytes for %u slots)\n", name,
+                page->version, page->size, VS_PAGE_VERSION, vehicle_state_pub_size(page->pub.state.n_slots),
+                page->pub.state.n_slots);
+    } else {
+        full = mmap(NULL, page_bytes(page->size), PROT_READ, MAP_SHARED, fd, 0);
+        if (full == MAP_FAILED) {
+            perror("Vehicle state mmap failed");
+            full = NULL;
+        }
+    }
+
+    munmap((void *)page, page_bytes(0));
+    close(fd);
+    return full;
+}
+
+void vehicle_state_page_close(const struct vehicle_state_page *page) {
+    munmap((void *)page, page_bytes(page->size));
+}
+
+// The name goes first, so a writer starting now creates a new page rather than taking this one
+void vehicle_state_page_destroy(struct vehicle_state_page *page, const char *name) {
+    shm_unlink(name);
+    atomic_store((_Atomic int32_t *)&page->writer_pid, 0);
+    vehicle_state_page_close(page);
+}
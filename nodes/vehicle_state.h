@@ -0,0 +1,121 @@
+#ifndef VEHICLE_STATE_H
+#define VEHICLE_STATE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Vehicle state shared between the dashboard threads, and with other
+ * local processes through a shared memory page.
+ *
+ * Published through a sequence lock: writers bump the sequence to odd,
+ * update in place and bump it back to even; readers copy the whole struct
+ * and retry if the sequence moved. Readers never block writers, and a
+ * writer only ever waits for another writer's few stores, never for a
+ * render.
+ *
+ * Writers (sensor, engine, input, db-watch contexts) serialise on a
+ * mutex outside the sequence rather than spinning for it: a writer
+ * preempted mid-update puts the others to sleep instead of burning their
+ * timeslice, which on one core would be spent waiting for the preempted
+ * writer to run again. The mutex inherits priority, so the holder runs
+ * at its highest waiter's priority until it is done. Readers never touch
+ * it.
+ *
+ *   struct vehicle_state *vs = vehicle_state_write_begin(vehicle);
+ *   vs->door = 1;
+ *   vehicle_state_write_end(vehicle);
+ *
+ *   struct vehicle_state *snap = vehicle_state_alloc(vehicle->state.n_slots);
+ *   vehicle_state_read(vehicle, snap);
+ *
+ * The sensor entries are sized when the state is created, one per slot of
+ * the signal database (struct signal_db.n_slots), so the state grows with
+ * the database rather than with a fixed table; snapshots are allocated for
+ * the publisher's n_slots.
+ *
+ * The dashboard keeps the published state in a POSIX shared memory
+ * object, so other processes map it read-only and take snapshots with
+ * the same protocol: no syscalls per read and nothing the dashboard
+ * waits for. The page header carries a layout version and the state's
+ * size; a reader built against another layout is refused at open, and
+ * maps as many sensor entries as the writer created.
+ *
+ *   const struct vehicle_state_page *page = vehicle_state_page_open(VS_PAGE_NAME);
+ *   if (vehicle_state_try_read(&page->pub, snap, &seq) < 0) ... writer died mid-update
+ */
+
+#define VS_NOTICE_LEN   128
+#define VS_MAX_SLOTS    UINT16_MAX  // n_slots is 16 bits, on the wire too
+
+struct vehicle_sensor {
+    int32_t raw;                    // raw signal units
+    uint8_t stale;                  // its message missed its deadline
+};
+
+struct vehicle_state {
+    uint8_t left_ind;               // lamp / status flags, 1 = on, closed, fastened
+    uint8_t right_ind;
+    uint8_t headlight;
+    uint8_t engine;                 // engine state machine step, 0 = idle (off)
+    uint8_t door;
+    uint8_t seatbelt;
+    uint16_t n_slots;               // sensor entries, fixed when the state is created
+    uint32_t alarms;                // active alarm rules, bit per rule in file order
+    char notice[VS_NOTICE_LEN];     // last error/notice for the operator
+    struct vehicle_sensor sensor[]; // per slot of the signal database
+};
+
+struct vehicle_state_pub {
+    _Atomic uint32_t seq;           // odd while a write is in progress
+    pthread_mutex_t write_lock;     // writers of the owning process only
+    struct vehicle_state state;
+};
+
+// Shared memory page
+#define VS_PAGE_NAME     "/dashboard_state"    // shm_open() name, /dev/shm/dashboard_state
+#define VS_PAGE_MAGIC    0x31545356            // "VST1"
+#define VS_PAGE_VERSION  5                     // bump on any change to struct vehicle_state
+#define VS_READ_SPINS    (1u << 20)            // odd this long: the writer is gone
+
+struct vehicle_state_page {
+    uint32_t magic;                 // set last, once the page is initialised
+    uint16_t version;
+    uint16_t reserved;
+    int32_t  writer_pid;            // 0 once the writer has shut down
+    uint32_t size;                  // vehicle_state_pub_size() of the state it holds, fixed
+    struct vehicle_state_pub pub;
+};
+
+// Bytes of a state with n_slots sensor entries, and of its published form
+size_t vehicle_state_size(uint32_t n_slots);
+size_t vehicle_state_pub_size(uint32_t n_slots);
+// Zeroed state with n_slots sensor entries, for snapshots; free() it. NULL on error
+struct vehicle_state *vehicle_state_alloc(uint32_t n_slots);
+
+// pub must hold vehicle_state_pub_size(n_slots) bytes
+void vehicle_state_init(struct vehicle_state_pub *pub, uint32_t n_slots);
+struct vehicle_state *vehicle_state_write_begin(struct vehicle_state_pub *pub);
+void vehicle_state_write_end(struct vehicle_state_pub *pub);
+
+// Consistent copy of the state into out, allocated for the same n_slots; returns the
+// sequence it was taken at
+uint32_t vehicle_state_read(const struct vehicle_state_pub *pub, struct vehicle_state *out);
+
+// Same for readers in other processes, which must not spin on a dead writer: -1 if the
+// sequence stays odd for VS_READ_SPINS polls, else 0 and *out is consistent (as of *seq)
+int vehicle_state_try_read(const struct vehicle_state_pub *pub, struct vehicle_state *out, uint32_t *seq);
+
+// Writer: creates the named page with an initialised state of n_slots sensor entries, or
+// takes over one whose writer has died; NULL on error or while another live writer owns it
+struct vehicle_state_page *vehicle_state_page_create(const char *name, uint32_t n_slots);
+// Reader: read-only mapping of the whole state, NULL if missing, not yet initialised or
+// another layout version. Snapshots are allocated for page->pub.state.n_slots
+const struct vehicle_state_page *vehicle_state_page_open(const char *name);
+void vehicle_state_page_close(const struct vehicle_state_page *page);
+// Writer shutdown: marks the page abandoned for readers still mapping it, removes the name
+void vehicle_state_page_destroy(struct vehicle_state_page *page, const char *name);
+
+#endif
@@ -0,0 +1,458 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "widget.h"
+
+struct frame {
+    struct layout *l;
+    struct screen *scr;
+    const struct vehicle_state *vs;
+    const struct signal_db *db;
+    uint64_t now_us;
+};
+
+static int flag_value(const struct vehicle_state *vs, int flag) {
+    switch (flag) {
+        case WIDGET_LEFT_IND:  return vs->left_ind;
+        case WIDGET_RIGHT_IND: return vs->right_ind;
+        case WIDGET_HEADLIGHT: return vs->headlight;
+        case WIDGET_ENGINE_ON: return vs->engine;
+        case WIDGET_DOOR:      return vs->door;
+        case WIDGET_SEATBELT:  return vs->seatbelt;
+        default:               return 0;
+    }
+}
+
+static int has_signal(const struct widget *w) {
+    return w->type == WIDGET_VALUE || w->type == WIDGET_STATUS || w->type == WIDGET_TREND;
+}
+
+// ============ Setup ============
+// Which inputs a widget is drawn from (its signal is signal of the layout); returns how many
+static int widget_inputs(const struct widget *w, uint32_t signal, uint32_t *in) {
+    switch (w->type) {
+        case WIDGET_FLAG:   in[0] = WIDGET_IN_FLAG + w->bind;         return 1;
+        case WIDGET_ENGINE: in[0] = WIDGET_IN_FLAG + WIDGET_ENGINE_ON; return 1;
+        case WIDGET_VALUE:  in[0] = WIDGET_IN_SIGNAL + signal;        return 1;
+        case WIDGET_STATUS: in[0] = WIDGET_IN_SIGNAL + signal; in[1] = WIDGET_IN_ALARMS; return 2;
+        case WIDGET_TREND:  in[0] = WIDGET_IN_SIGNAL + signal; in[1] = WIDGET_IN_TIME;   return 2;
+        case WIDGET_ALARMS: in[0] = WIDGET_IN_ALARMS;                 return 1;
+        case WIDGET_NOTICE: in[0] = WIDGET_IN_NOTICE;                 return 1;
+        default:            return 0;
+    }
+}
+
+static int widget_valid(const struct widget *w, const struct layout_source *src) {
+    switch (w->type) {
+        case WIDGET_FLAG:
+            return w->bind >= 0 && w->bind <= WIDGET_SEATBELT;
+        case WIDGET_VALUE:
+            return w->signal != NULL && src->value != NULL;
+        case WIDGET_STATUS:
+            return w->signal != NULL && src->value != NULL && src->alarms != NULL;
+        case WIDGET_TREND:
+            return w->signal != NULL && src->value != NULL && src->history != NULL &&
+                   src->trend_points >= 1 && src->trend_points <= WIDGET_TREND_MAX && src->trend_span_s > 0;
+        case WIDGET_ALARMS:
+            return src->alarms != NULL;
+        default:
+            return w->type <= WIDGET_NOTICE;
+    }
+}
+
+// The signal called name among the first n of the layout, n if none
+static uint32_t signal_find(const struct layout *l, uint32_t n, const char *name) {
+    uint32_t k = 0;
+    while (k < n && strcmp(l->signals[k].name, name) != 0)
+        k++;
+    return k;
+}
+
+int layout_init(struct layout *l, const struct widget *w, uint32_t n, const struct layout_source *src) {
+    uint32_t in[2];
+
+    memset(l, 0, sizeof(*l));
+    for (uint32_t i = 0; i < n; i++) {
+        if (!widget_valid(&w[i], src)) {
+            fprintf(stderr, "layout: widget %u (row %u col %u) is invalid\n", i, w[i].row, w[i].col);
+            return -1;
+        }
+    }
+
+    l->signals   = calloc(n ? n : 1, sizeof(*l->signals));
+    l->signal_of = malloc((n ? n : 1) * sizeof(*l->signal_of));
+    l->dirty     = calloc((n + 63) / 64 + 1, sizeof(*l->dirty));
+    l->lo        = malloc((n ? n : 1) * sizeof(*l->lo));
+    l->hi        = malloc((n ? n : 1) * sizeof(*l->hi));
+    l->shown     = vehicle_state_alloc(0);
+    if (!l->signals || !l->signal_of || !l->dirty || !l->lo || !l->hi || !l->shown)
+        goto fail;
+
+    // One entry per signal name, however many widgets show it
+    for (uint32_t i = 0; i < n; i++) {
+        l->signal_of[i] = UINT32_MAX;
+        if (!has_signal(&w[i]))
+            continue;
+        uint32_t k = signal_find(l, l->n_signals, w[i].signal);
+        if (k == l->n_signals) {
+            l->signals[k].name = w[i].signal;
+            l->signals[k].sig  = -1;
+            l->n_signals++;
+        }
+        l->signals[k].status |= w[i].type == WIDGET_STATUS;
+        l->signal_of[i] = k;
+    }
+
+    uint32_t inputs = WIDGET_IN_SIGNAL + l->n_signals, total = 0;
+    l->first = calloc(inputs + 1, sizeof(*l->first));
+    if (l->first == NULL)
+        goto fail;
+    for (uint32_t i = 0; i < n; i++)
+        for (int k = widget_inputs(&w[i], l->signal_of[i], in) - 1; k >= 0; k--)
+            l->first[in[k] + 1]++;
+    for (uint32_t i = 0; i < inputs; i++)
+        l->first[i + 1] += l->first[i];
+    total = l->first[inputs];
+
+    uint32_t *next = malloc((inputs ? inputs : 1) * sizeof(*next));
+    l->index = malloc((total ? total : 1) * sizeof(*l->index));
+    if (next == NULL || l->index == NULL) {
+        free(next);
+        goto fail;
+    }
+    memcpy(next, l->first, inputs * sizeof(*next));
+    for (uint32_t i = 0; i < n; i++)
+        for (int k = widget_inputs(&w[i], l->signal_of[i], in) - 1; k >= 0; k--)
+            l->index[next[in[k]]++] = i;
+    free(next);
+
+    l->w   = w;
+    l->n   = n;
+    l->src = *src;
+    return 0;
+
+fail:
+    perror("layout alloc failed");
+    layout_free(l);
+    return -1;
+}
+
+void layout_free(struct layout *l) {
+    free(l->signals);
+    free(l->signal_of);
+    free(l->first);
+    free(l->index);
+    free(l->dirty);
+    free(l->lo);
+    free(l->hi);
+    free(l->by_slot);
+    free(l->shown);
+    l->signals = NULL;
+    l->signal_of = NULL;
+    l->first = l->index = NULL;
+    l->dirty = NULL;
+    l->lo = l->hi = NULL;
+    l->by_slot = NULL;
+    l->shown = NULL;
+    l->n = l->n_signals = l->n_slots = 0;
+}
+
+// Signals by name, their slots and alarm inputs and the value colour limits, for this
+// database version; -1 if the slot map cannot grow to the database's slots
+static int bind_signals(struct layout *l, const struct signal_db *db) {
+    if (db->n_slots != l->n_slots) {
+        uint32_t *by_slot = realloc(l->by_slot, (db->n_slots ? db->n_slots : 1) * sizeof(*by_slot));
+        if (by_slot == NULL)
+            return -1;
+        l->by_slot = by_slot;
+        l->n_slots = db->n_slots;
+    }
+    for (uint32_t slot = 0; slot < l->n_slots; slot++)
+        l->by_slot[slot] = UINT32_MAX;
+
+    for (uint32_t k = 0; k < l->n_signals; k++) {
+        struct layout_signal *s = &l->signals[k];
+        int32_t slot = -1;
+        s->sig = signal_db_lookup(db, s->name);
+        if (s->sig >= 0 && (slot = db->slot[s->sig]) >= 0)
+            l->by_slot[slot] = k;
+        s->alarm_in = (slot >= 0) ? ALARM_IN_SENSOR + slot : -1;
+    }
+
+    for (uint32_t i = 0; i < l->n; i++) {
+        const struct widget *w = &l->w[i];
+        int32_t sig = (w->type == WIDGET_VALUE) ? l->signals[l->signal_of[i]].sig : -1;
+
+        l->lo[i] = INT64_MIN;
+        l->hi[i] = INT64_MAX;
+        if (sig < 0)
+            continue;
+        l->lo[i] = isnan(w->warn_lo) ? db->warn_lo_raw[sig] : signal_raw_from_phys(&db->signals[sig], w->warn_lo);
+        l->hi[i] = isnan(w->warn_hi) ? db->warn_hi_raw[sig] : signal_raw_from_phys(&db->signals[sig], w->warn_hi);
+    }
+    return 0;
+}
+
+// ============ Alarms ============
+// Text of the signal's lowest active rule (by its first condition); 0 if none
+static int signal_alarm(const struct frame *f, const struct layout_signal *s, char *text, size_t len) {
+    if (s->alarm_in < 0)
+        return 0;
+    for (uint32_t m = f->vs->alarms; m; m &= m - 1)
+        if (alarm_describe(f->l->src.alarms, __builtin_ctz(m), text, len) == s->alarm_in)
+            return 1;
+    return 0;
+}
+
+// Active rules that no status widget shows: each takes its signal's first, a stale one none
+static uint32_t unclaimed_alarms(const struct frame *f) {
+    struct layout *l = f->l;
+    uint32_t left = f->vs->alarms;
+    char text[ALARM_TEXT_LEN];
+
+    for (uint32_t k = 0; k < l->n_signals; k++)
+        l->signals[k].claimed = 0;
+    for (uint32_t m = f->vs->alarms; m; m &= m - 1) {
+        int rule  = __builtin_ctz(m);
+        int input = alarm_describe(l->src.alarms, rule, text, sizeof(text));
+
+        for (uint32_t k = 0; input >= ALARM_IN_SENSOR && k < l->n_signals; k++) {
+            struct layout_signal *s = &l->signals[k];
+            if (s->status && !s->claimed && !s->stale && s->alarm_in == input) {
+                s->claimed = 1;
+                left &= ~(1u << rule);
+                break;
+            }
+        }
+    }
+    return left;
+}
+
+// ============ Widgets ============
+// Engineering units only here, on the render path
+static const char *raw_str(const struct signal_db *db, int32_t sig, int32_t raw, char *buf) {
+    if (sig < 0)
+        return "--";
+    fixed_to_str(buf, 16, fixed_from_raw(&db->fmt[sig], raw), db->fmt[sig].decimals);
+    return buf;
+}
+
+static void draw_value(const struct frame *f, uint32_t i) {
+    const struct widget *w = &f->l->w[i];
+    const struct layout_signal *s = &f->l->signals[f->l->signal_of[i]];
+    const char *str = w->text[1];
+    char buf[16];
+    uint8_t attr = (s->raw < f->l->lo[i] || s->raw > f->l->hi[i]) ? w->attr[1] : w->attr[0];
+
+    if (s->known && (s->raw != 0 || str == NULL))
+        str = raw_str(f->db, s->sig, s->raw, buf);
+    else if (str == NULL)
+        str = "--";
+    screen_attr(f->scr, s->stale ? SCR_DIM : attr);
+    screen_printf(f->scr, "%*s", WIDGET_VALUE_W, str);
+    screen_attr(f->scr, 0);
+    if (w->text[0])
+        screen_puts(f->scr, w->text[0]);
+}
+
+static void draw_status(const struct frame *f, uint32_t i) {
+    const struct widget *w = &f->l->w[i];
+    const struct layout_signal *s = &f->l->signals[f->l->signal_of[i]];
+    char text[ALARM_TEXT_LEN];
+
+    if (s->stale) {
+        screen_attr(f->scr, SCR_DIM);
+        screen_puts(f->scr, "[NO SIGNAL]");
+    } else if (signal_alarm(f, s, text, sizeof(text))) {
+        screen_attr(f->scr, w->attr[1]);
+        screen_printf(f->scr, "[WARNING: %s]", text);
+    } else if (w->text[0]) {
+        screen_attr(f->scr, w->attr[0]);
+        screen_puts(f->scr, w->text[0]);
+    }
+}
+
+// Sparkline of the signal's recent means, then its highest or lowest value lately
+static void draw_trend(const struct frame *f, uint32_t i) {
+    static const char *const bars[8] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    const struct layout_source *src = &f->l->src;
+    const struct widget *w = &f->l->w[i];
+    int32_t sig = f->l->signals[f->l->signal_of[i]].sig;
+    struct history_agg point[WIDGET_TREND_MAX], window;
+    int n = src->trend_points;
+    char buf[16];
+
+    if (sig < 0 || f->db->slot[sig] < 0)
+        return;
+    int slot = f->db->slot[sig];
+    if (signal_history_trend(src->history, slot, f->now_us, src->trend_span_s * 1000000ull, point, n) < 0 ||
+        signal_history_window(src->history, slot, f->now_us, src->trend_window_s * 1000000ull, &window) < 0 ||
+        !window.valid)
+        return;
+
+    int32_t lo = INT32_MAX, hi = INT32_MIN;
+    for (int k = 0; k < n; k++) {
+        if (!point[k].valid)
+            continue;
+        if (point[k].mean < lo) lo = point[k].mean;
+        if (point[k].mean > hi) hi = point[k].mean;
+    }
+
+    for (int k = 0; k < n; k++)
+        screen_puts(f->scr, !point[k].valid ? " " : bars[(hi > lo) ? (int64_t)(point[k].mean - lo) * 7 / (hi - lo) : 0]);
+    screen_printf(f->scr, " %um %s %s", src->trend_window_s / 60, w->arg ? "max" : "min",
+                  raw_str(f->db, sig, w->arg ? window.max : window.min, buf));
+}
+
+static void draw_alarms(const struct frame *f, const struct widget *w) {
+    uint32_t alarms = unclaimed_alarms(f);
+    char text[ALARM_TEXT_LEN];
+
+    if (alarms == 0)
+        return;
+    screen_attr(f->scr, w->attr[1]);
+    screen_puts(f->scr, w->label ? w->label : "WARNING:");
+    for (; alarms; alarms &= alarms - 1) {
+        alarm_describe(f->l->src.alarms, __builtin_ctz(alarms), text, sizeof(text));
+        screen_printf(f->scr, " [%s]", text);
+    }
+}
+
+static void draw_widget(const struct frame *f, uint32_t i) {
+    const struct layout_source *src = &f->l->src;
+    const struct widget *w = &f->l->w[i];
+    struct screen *scr = f->scr;
+
+    screen_box(scr, w->row, w->col, w->width);
+    screen_attr(scr, (w->type == WIDGET_TEXT) ? w->attr[0] : 0);
+    if (w->label && w->type != WIDGET_ALARMS)
+        screen_puts(scr, w->label);
+
+    switch (w->type) {
+        case WIDGET_FLAG: {
+            int on = flag_value(f->vs, w->bind) == w->arg;
+            screen_attr(scr, w->attr[on]);
+            screen_puts(scr, w->text[on] ? w->text[on] : "");
+            break;
+        }
+        case WIDGET_ENGINE:
+            if (f->vs->engine == 0 || f->vs->engine == w->arg) {
+                int on = f->vs->engine != 0;
+                screen_attr(scr, w->attr[on]);
+                screen_puts(scr, w->text[on] ? w->text[on] : "");
+            } else {
+                screen_attr(scr, w->attr[2]);
+                screen_printf(scr, "%s...", f->vs->engine < src->n_steps ? src->steps[f->vs->engine] : "?");
+            }
+            break;
+        case WIDGET_VALUE:  draw_value(f, i);     break;
+        case WIDGET_STATUS: draw_status(f, i);    break;
+        case WIDGET_TREND:  draw_trend(f, i);     break;
+        case WIDGET_ALARMS: draw_alarms(f, w);    break;
+        case WIDGET_NOTICE:
+            screen_attr(scr, w->attr[0]);
+            screen_puts(scr, f->vs->notice);
+            break;
+    }
+    screen_attr(scr, 0);
+}
+
+// ============ Render ============
+static void mark_input(struct layout *l, uint32_t input) {
+    for (uint32_t k = l->first[input]; k < l->first[input + 1]; k++)
+        l->dirty[l->index[k] / 64] |= 1ull << (l->index[k] % 64);
+}
+
+// Takes the signal's value from the new snapshot; returns 1 if it changed, 2 if its staleness did
+static int signal_read(const struct layout *l, struct layout_signal *s, const struct vehicle_state *vs,
+                       const struct signal_db *db) {
+    int32_t raw = 0;
+    int stale = 0;
+    int known = s->sig >= 0 && l->src.value(vs, db, s->sig, &raw, &stale);
+
+    stale = known && stale;
+    int moved   = stale != s->stale;
+    int changed = moved || known != s->known || raw != s->raw;
+    s->known = known;
+    s->raw   = raw;
+    s->stale = stale;
+    return changed | moved << 1;
+}
+
+// Reads signal k of the layout again, marking its widgets if it changed; returns 1 if
+// its staleness moved an alarm between its status widget and the shared line
+static int signal_changed(struct layout *l, uint32_t k, const struct vehicle_state *vs,
+                          const struct signal_db *db) {
+    int changed = signal_read(l, &l->signals[k], vs, db);
+
+    if (changed)
+        mark_input(l, WIDGET_IN_SIGNAL + k);
+    return (changed & 2) && l->signals[k].status;
+}
+
+// Marks the widgets of every input that differs between the snapshot on screen and the new
+// one: flags, alarms and notice by comparison, signals only in the changed slots
+static void mark_changed(struct layout *l, const struct vehicle_state *vs, const struct signal_db *db,
+                         const uint64_t *changed, uint64_t bucket) {
+    const struct vehicle_state *old = l->shown;
+    int alarms = vs->alarms != old->alarms;
+
+    for (int flag = WIDGET_LEFT_IND; flag <= WIDGET_SEATBELT; flag++)
+        if (flag_value(vs, flag) != flag_value(old, flag))
+            mark_input(l, WIDGET_IN_FLAG + flag);
+    if (changed == NULL) {
+        for (uint32_t k = 0; k < l->n_signals; k++)
+            alarms |= signal_changed(l, k, vs, db);
+    } else {
+        for (uint32_t word = 0; word < (l->n_slots + 63) / 64; word++)
+            for (uint64_t bits = changed[word]; bits; bits &= bits - 1) {
+                uint32_t k = l->by_slot[word * 64 + __builtin_ctzll(bits)];
+                if (k != UINT32_MAX)
+                    alarms |= signal_changed(l, k, vs, db);
+            }
+    }
+    if (alarms)
+        mark_input(l, WIDGET_IN_ALARMS);
+    if (strncmp(vs->notice, old->notice, VS_NOTICE_LEN) != 0)
+        mark_input(l, WIDGET_IN_NOTICE);
+    if (bucket != l->bucket)
+        mark_input(l, WIDGET_IN_TIME);
+}
+
+int layout_render(struct layout *l, struct screen *scr, const struct vehicle_state *vs,
+                  const struct signal_db *db, const uint64_t *changed, uint64_t now_us) {
+    struct frame f = {l, scr, vs, db, now_us};
+    uint64_t point_us = l->src.trend_points ? l->src.trend_span_s * 1000000ull / l->src.trend_points : 0;
+    uint64_t bucket = point_us ? now_us / point_us : 0;
+    uint32_t words = (l->n + 63) / 64;
+    int redrawn = 0;
+
+    if (!l->drawn || db->generation != l->generation) {
+        if (bind_signals(l, db) < 0)
+            return 0;
+        for (uint32_t k = 0; k < l->n_signals; k++)
+            signal_read(l, &l->signals[k], vs, db);
+        for (uint32_t i = 0; i < l->n; i++)
+            l->dirty[i / 64] |= 1ull << (i % 64);
+    } else {
+        mark_changed(l, vs, db, changed, bucket);
+    }
+    memcpy(l->shown, vs, vehicle_state_size(0));
+    l->shown->n_slots = 0;
+    l->bucket     = bucket;
+    l->generation = db->generation;
+    l->drawn      = 1;
+
+    for (uint32_t word = 0; word < words; word++)
+        for (uint64_t bits = l->dirty[word]; bits; bits &= bits - 1) {
+            draw_widget(&f, word * 64 + __builtin_ctzll(bits));
+            redrawn++;
+        }
+    memset(l->dirty, 0, words * sizeof(*l->dirty));
+    screen_unbox(scr);
+
+    l->frames++;
+    l->redrawn += redrawn;
+    return redrawn;
+}
@@ -0,0 +1,137 @@
+#ifndef WIDGET_H
+#define WIDGET_H
+
+#include <stdint.h>
+#include "alarm.h"
+#include "screen.h"
+#include "signal_history.h"
+#include "signal_db.h"
+#include "vehicle_state.h"
+
+/*
+ * Table-driven dashboard layout.
+ *
+ * The screen is an array of widgets, each a one-row box at a fixed place,
+ * bound to what it shows (a vehicle flag, a database signal by name, the
+ * alarms, the notice) and styled by its table entry. Showing another
+ * signal is one more entry:
+ *
+ *   {WIDGET_VALUE, 19, 0, 19, -1, .signal = "ambient_temp", .label = "Ambient: ", .text = {" °C"},
+ *    .warn_lo = NAN, .warn_hi = NAN},
+ *
+ * layout_render() redraws only the widgets bound to what changed since
+ * the screen was drawn. Flags, alarms and the notice are compared with
+ * the snapshot drawn last; signals are only looked at if the caller's
+ * changed set (a bitmap of application slots, kept by whoever writes the
+ * values) names their slot. Every signal the table names keeps the list
+ * of its widgets and the value it was drawn with, so a frame costs the
+ * signals that changed plus their widgets, however many are shown.
+ *
+ * Signal values come from the caller (struct layout_source), so the
+ * layout does not care where they are kept; alarms and trends go by the
+ * signal's application slot, as the alarm rules and the history do.
+ */
+
+// Widget types
+#define WIDGET_TEXT    0    // label in attr[0]
+#define WIDGET_FLAG    1    // label, then text[1] in attr[1] if the flag equals arg, else text[0] in attr[0]
+#define WIDGET_ENGINE  2    // label, then text[0] / text[1] in attr[0] / attr[1] at step 0 / step arg,
+                            // the step's name (layout_source.steps) in attr[2] in between
+#define WIDGET_VALUE   3    // label, signal value in attr[0] (attr[1] outside warn_lo..warn_hi), then text[0];
+                            // text[1] stands in while the value is 0 or missing. Dimmed while stale
+#define WIDGET_STATUS  4    // signal's first alarm in attr[1], text[0] in attr[0] without one, or no signal
+#define WIDGET_TREND   5    // signal sparkline, then its recent max (arg 1) or min (arg 0)
+#define WIDGET_ALARMS  6    // alarms no status widget shows, in attr[1]
+#define WIDGET_NOTICE  7    // the notice line in attr[0]
+
+// Vehicle flags, bound by WIDGET_FLAG
+#define WIDGET_LEFT_IND   0
+#define WIDGET_RIGHT_IND  1
+#define WIDGET_HEADLIGHT  2
+#define WIDGET_ENGINE_ON  3
+#define WIDGET_DOOR       4
+#define WIDGET_SEATBELT   5
+
+// Inputs a widget can depend on
+#define WIDGET_IN_FLAG    0     // + flag
+#define WIDGET_IN_ALARMS  6
+#define WIDGET_IN_NOTICE  7
+#define WIDGET_IN_TIME    8     // the trend moved on by a point
+#define WIDGET_IN_SIGNAL  9     // + signal of the layout (struct layout_signal)
+
+#define WIDGET_TREND_MAX  64    // sparkline points at most
+#define WIDGET_VALUE_W    6     // values are right-aligned in this many columns
+
+struct widget {
+    uint8_t     type;
+    uint8_t     row, col, width;
+    int16_t     bind;           // flag, -1 for none
+    const char *signal;         // value, status and trend widgets: database signal name
+    int16_t     arg;            // by type: flag value that reads as on, running engine step,
+                                // trend shows the max
+    const char *label;          // drawn in the default style
+    const char *text[2];
+    uint8_t     attr[3];
+    double      warn_lo, warn_hi;   // physical; NAN takes the database limit
+};
+
+// What the widgets are drawn from besides the state snapshot, owned by the caller
+struct layout_source {
+    // Raw value of database signal sig in vs and whether it is stale; 0 if vs has none
+    int (*value)(const struct vehicle_state *vs, const struct signal_db *db, int32_t sig,
+                 int32_t *raw, int *stale);
+    struct alarm_set      *alarms;      // rules behind vs->alarms
+    struct signal_history *history;     // trend widgets
+    uint32_t trend_points;              // sparkline points, 1..WIDGET_TREND_MAX
+    uint32_t trend_span_s;              // time the sparkline covers
+    uint32_t trend_window_s;            // recent extreme shown next to it
+    const char *const *steps;           // engine widgets: name of each vehicle_state.engine step
+    uint32_t n_steps;
+};
+
+// A signal the table names, resolved again for each database version
+struct layout_signal {
+    const char *name;
+    int32_t  sig;               // database signal, -1 if this version lacks it
+    int32_t  alarm_in;          // its alarm input, -1 without an application slot
+    uint8_t  status;            // a status widget shows its alarm
+    uint8_t  claimed;           // scratch: that widget has taken a rule this frame
+    int32_t  raw;               // as drawn
+    uint8_t  known, stale;
+};
+
+struct layout {
+    const struct widget *w;
+    uint32_t n;
+    struct layout_source src;
+
+    // Widgets of input i: index[first[i] .. first[i + 1]), signals from WIDGET_IN_SIGNAL
+    struct layout_signal *signals;
+    uint32_t n_signals;
+    uint32_t *first;
+    uint32_t *index;
+    uint32_t *signal_of;        // widget -> its signal of the layout, UINT32_MAX if none
+    uint32_t *by_slot;          // application slot -> signal of the layout, UINT32_MAX if none
+    uint32_t n_slots;
+    uint64_t *dirty;            // bit per widget
+    int64_t  *lo, *hi;          // value limits in raw units, per widget
+
+    struct vehicle_state *shown;    // flags, alarms and notice drawn from; no sensors
+    uint32_t generation;        // database the signals, limits and formats come from
+    uint64_t bucket;            // trend point drawn last
+    int      drawn;
+
+    uint64_t frames, redrawn;   // widgets redrawn over all frames
+};
+
+int  layout_init(struct layout *l, const struct widget *w, uint32_t n, const struct layout_source *src);
+void layout_free(struct layout *l);
+
+// Redraws the widgets whose inputs changed since the last call (all of them the first
+// time and after a database change) into scr; returns how many were redrawn. changed
+// is a bitmap of db->n_slots slots whose values were written since the last call, NULL
+// to read every shown signal
+int  layout_render(struct layout *l, struct screen *scr, const struct vehicle_state *vs,
+                   const struct signal_db *db, const uint64_t *changed, uint64_t now_us);
+
+#endif